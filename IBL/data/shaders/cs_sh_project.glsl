@@ -0,0 +1,86 @@
+#version 450 core
+
+// 把环境光投影到L2球谐（9个系数），每个work group输出一份部分和，由cs_sh_reduce.glsl汇总
+
+const uint NumCoefficients = 9;
+const uint GroupSize = 16 * 16;
+
+layout(local_size_x=16, local_size_y=16, local_size_z=1) in;
+
+// 未预滤波环境贴图中尺寸较小的某一层mipmap
+layout(binding=0, rgba16f) restrict readonly uniform imageCube inputTexture;
+
+// rgb为系数的部分和，w为立体角的部分和
+layout(std430, binding=0) restrict writeonly buffer PartialSums
+{
+	vec4 partialSums[];
+};
+
+shared vec4 groupSums[GroupSize];
+
+// 与其他计算着色器相同的面方向，但不归一化，顺便求出纹素对应的立体角
+vec3 getSamplingVector(out float solidAngle)
+{
+	vec2 size = vec2(imageSize(inputTexture));
+	vec2 st = (gl_GlobalInvocationID.xy + 0.5) / size;
+	vec2 uv = 2.0 * vec2(st.x, 1.0-st.y) - vec2(1.0);
+
+	vec3 ret;
+	if(gl_GlobalInvocationID.z == 0)      ret = vec3(1.0,  uv.y, -uv.x);
+	else if(gl_GlobalInvocationID.z == 1) ret = vec3(-1.0, uv.y,  uv.x);
+	else if(gl_GlobalInvocationID.z == 2) ret = vec3(uv.x, 1.0, -uv.y);
+	else if(gl_GlobalInvocationID.z == 3) ret = vec3(uv.x, -1.0, uv.y);
+	else if(gl_GlobalInvocationID.z == 4) ret = vec3(uv.x, uv.y, 1.0);
+	else if(gl_GlobalInvocationID.z == 5) ret = vec3(-uv.x, uv.y, -1.0);
+
+	// 面积为(2/size)^2的纹素投影到单位球上：dA / (1 + u^2 + v^2)^(3/2)
+	float invLength = inversesqrt(dot(ret, ret));
+	solidAngle = 4.0 / (size.x * size.y) * invLength * invLength * invLength;
+	return ret * invLength;
+}
+
+void main(void)
+{
+	ivec2 inputSize = imageSize(inputTexture);
+	bool inside = gl_GlobalInvocationID.x < inputSize.x && gl_GlobalInvocationID.y < inputSize.y;
+
+	float solidAngle;
+	vec3 N = getSamplingVector(solidAngle);
+	vec3 radiance = vec3(0);
+	if(inside) {
+		radiance = imageLoad(inputTexture, ivec3(gl_GlobalInvocationID)).rgb * solidAngle;
+	}
+	else {
+		solidAngle = 0.0;
+	}
+
+	float basis[NumCoefficients];
+	basis[0] = 0.282095;
+	basis[1] = 0.488603 * N.y;
+	basis[2] = 0.488603 * N.z;
+	basis[3] = 0.488603 * N.x;
+	basis[4] = 1.092548 * N.x * N.y;
+	basis[5] = 1.092548 * N.y * N.z;
+	basis[6] = 0.315392 * (3.0 * N.z * N.z - 1.0);
+	basis[7] = 1.092548 * N.x * N.z;
+	basis[8] = 0.546274 * (N.x * N.x - N.y * N.y);
+
+	uint groupIndex = (gl_WorkGroupID.z * gl_NumWorkGroups.y + gl_WorkGroupID.y) * gl_NumWorkGroups.x + gl_WorkGroupID.x;
+	uint localIndex = gl_LocalInvocationIndex;
+
+	// 每个系数在shared memory里做一次树形归约
+	for(uint k=0; k<NumCoefficients; ++k) {
+		groupSums[localIndex] = vec4(radiance * basis[k], solidAngle);
+		barrier();
+		for(uint stride = GroupSize / 2; stride > 0; stride >>= 1) {
+			if(localIndex < stride) {
+				groupSums[localIndex] += groupSums[localIndex + stride];
+			}
+			barrier();
+		}
+		if(localIndex == 0) {
+			partialSums[groupIndex * NumCoefficients + k] = groupSums[0];
+		}
+		barrier();
+	}
+}
@@ -0,0 +1,37 @@
+#version 450 core
+
+// 汇总cs_sh_project.glsl输出的部分和，得到最终的球谐系数
+
+const float PI = 3.141592;
+const uint NumCoefficients = 9;
+
+// 余弦核卷积后各阶的系数 A_l / PI，这样着色器中直接求和即是 irradiance / PI
+const float BandFactor[3] = float[](1.0, 2.0 / 3.0, 0.25);
+
+layout(local_size_x=9, local_size_y=1, local_size_z=1) in;
+
+layout(std430, binding=0) restrict readonly buffer PartialSums
+{
+	vec4 partialSums[];
+};
+
+layout(std430, binding=1) restrict writeonly buffer Coefficients
+{
+	vec4 coefficients[NumCoefficients];
+};
+
+uniform int numGroups;
+
+void main(void)
+{
+	uint k = gl_LocalInvocationID.x;
+
+	vec4 sum = vec4(0);
+	for(uint i=0; i<uint(numGroups); ++i) {
+		sum += partialSums[i * NumCoefficients + k];
+	}
+
+	// 把立体角之和修正为4PI，消除离散化误差
+	uint band = (k == 0u) ? 0u : (k < 4u ? 1u : 2u);
+	coefficients[k] = vec4(sum.rgb * (4.0 * PI / sum.w) * BandFactor[band], 0.0);
+}
@@ -27,21 +27,18 @@ layout(std140, binding=1) uniform ShadingUniforms
 {
 	AnalyticalLight lights[NumLights];
 	vec3 eyePosition;
+	// L2гϵҺ˾PI
+	vec4 irradianceSH[9];
 };
 
 layout(binding=0) uniform sampler2D albedoTexture;
 layout(binding=1) uniform sampler2D normalTexture;
-layout(binding=2) uniform sampler2D metalnessTexture;
-layout(binding=3) uniform sampler2D roughnessTexture;
+// RAOGֲڶȣBȣʱȱʧͼѾĬֵ
+layout(binding=2) uniform sampler2D ormTexture;
 layout(binding=4) uniform samplerCube specularTexture;
-layout(binding=5) uniform samplerCube irradianceTexture;
 layout(binding=6) uniform sampler2D specularBRDF_LUT;
-layout(binding=7) uniform sampler2D occlusionTexture;
 layout(binding=8) uniform sampler2D emmisiveTexture;
 
-uniform bool haveMetalness;
-uniform bool haveRoughness;
-uniform bool haveOcclusion;
 uniform bool haveEmission;
 
 
@@ -72,6 +69,20 @@ vec3 fresnelSchlick(vec3 F0, float cosTheta)
 	return F0 + (vec3(1.0) - F0) * pow(1.0 - cosTheta, 5.0);
 }
 
+// гϵ߷ irradiance / PI
+vec3 irradianceFromSH(vec3 N)
+{
+	return irradianceSH[0].rgb * 0.282095
+		+ irradianceSH[1].rgb * (0.488603 * N.y)
+		+ irradianceSH[2].rgb * (0.488603 * N.z)
+		+ irradianceSH[3].rgb * (0.488603 * N.x)
+		+ irradianceSH[4].rgb * (1.092548 * N.x * N.y)
+		+ irradianceSH[5].rgb * (1.092548 * N.y * N.z)
+		+ irradianceSH[6].rgb * (0.315392 * (3.0 * N.z * N.z - 1.0))
+		+ irradianceSH[7].rgb * (1.092548 * N.x * N.z)
+		+ irradianceSH[8].rgb * (0.546274 * (N.x * N.x - N.y * N.y));
+}
+
 // IBLΪ˽kdӻȡĽ
 vec3 fresnelRoughness(vec3 F0, float cosTheta, float roughness)
 {
@@ -81,15 +92,14 @@ vec3 fresnelRoughness(vec3 F0, float cosTheta, float roughness)
 void main()
 {
 	vec3 albedo = texture(albedoTexture, vin.texcoord).rgb;
-	float metalness = 0.0;
-	float roughness = 0.5;
-	if(haveMetalness)
-		metalness = texture(metalnessTexture, vin.texcoord).r;
-	if(haveRoughness)
-		roughness = texture(roughnessTexture, vin.texcoord).r;
+	vec3 orm = texture(ormTexture, vin.texcoord).rgb;
+	float metalness = orm.b;
+	float roughness = orm.g;
 
 	vec3 V = normalize(eyePosition - vin.position);
-	vec3 N = normalize(2.0 * texture(normalTexture, vin.texcoord).rgb - 1.0);
+	// ͼֻxyRG8BC5zɵλؽ߿ռzǷǸ
+	vec2 Nxy = 2.0 * texture(normalTexture, vin.texcoord).rg - 1.0;
+	vec3 N = normalize(vec3(Nxy, sqrt(max(1.0 - dot(Nxy, Nxy), 0.0))));
 	N = normalize(vin.tangentBasis * N);
 	
 	float NdotV = max(0.0, dot(N, V));
@@ -129,7 +139,7 @@ void main()
 
 	// 
 	vec3 ambientLighting;
-	vec3 irradiance = texture(irradianceTexture, N).rgb;
+	vec3 irradiance = max(irradianceFromSH(N), vec3(0.0));
 
 	vec3 Froughness = fresnelRoughness(F0, NdotV, roughness);
 	vec3 kd = mix(vec3(1.0) - Froughness, vec3(0.0), metalness);
@@ -147,9 +157,7 @@ void main()
 	ambientLighting = diffuseIBL + specularIBL;
 	
 	// ڱ
-	float AO = 1.0f;
-	if(haveOcclusion)
-		AO = texture(occlusionTexture, vin.texcoord).r;
+	float AO = orm.r;
 	
 	// Է
 	vec3 emmision = vec3(0);
@@ -1,7 +1,8 @@
 #version 450 core
 
-layout(location=0) in vec3 position;
-layout(location=1) in vec3 normal;
+// packedVerticesʱpositionxyzΪΧλãwΪ߷normalxyzwΪķߺ
+layout(location=0) in vec4 position;
+layout(location=1) in vec4 normal;
 layout(location=2) in vec2 texcoord;
 layout(location=3) in vec3 tangent;
 layout(location=4) in vec3 bitangent;
@@ -21,12 +22,38 @@ layout(location=0) out Vertex
 	mat3 tangentBasis;
 } vout;
 
+uniform bool packedVertices;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+vec3 octahedralDecode(vec2 e)
+{
+	vec3 v = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-v.z, 0.0);
+	v.x += v.x >= 0.0 ? -t : t;
+	v.y += v.y >= 0.0 ? -t : t;
+	return normalize(v);
+}
+
 void main()
 {
-	vout.position = vec3(model * vec4(position, 1.0));
+	vec3 P;
+	mat3 TBN;
+	if (packedVertices) {
+		P = positionOffset + position.xyz * positionScale;
+		vec3 N = octahedralDecode(normal.xy);
+		vec3 T = octahedralDecode(normal.zw);
+		TBN = mat3(T, cross(N, T) * (position.w * 2.0 - 1.0), N);
+	}
+	else {
+		P = position.xyz;
+		TBN = mat3(tangent, bitangent, normal.xyz);
+	}
+
+	vout.position = vec3(model * vec4(P, 1.0));
 	vout.texcoord = vec2(texcoord.x, 1.0-texcoord.y);
 
-	vout.tangentBasis = mat3(model) * mat3(tangent, bitangent, normal);
+	vout.tangentBasis = mat3(model) * TBN;
 
-	gl_Position = projection * view * model * vec4(position, 1.0);
+	gl_Position = projection * view * model * vec4(P, 1.0);
 }
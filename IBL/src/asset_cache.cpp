@@ -0,0 +1,63 @@
+#include "asset_cache.hpp"
+
+AssetCache::AssetCache(size_t budget)
+	: m_budget(budget)
+	, m_usage(0)
+{}
+
+std::shared_ptr<void> AssetCache::findAsset(const std::string& key)
+{
+	const auto it = m_index.find(key);
+	if (it == m_index.end()) {
+		return nullptr;
+	}
+	m_entries.splice(m_entries.begin(), m_entries, it->second);
+	return it->second->asset;
+}
+
+void AssetCache::insert(const std::string& key, const std::shared_ptr<void>& asset, size_t bytes)
+{
+	const auto it = m_index.find(key);
+	if (it != m_index.end()) {
+		m_usage -= it->second->bytes;
+		m_entries.erase(it->second);
+	}
+	m_entries.push_front({ key, asset, bytes });
+	m_index[key] = m_entries.begin();
+	m_usage += bytes;
+	evict();
+}
+
+void AssetCache::resize(const std::string& key, size_t bytes)
+{
+	const auto it = m_index.find(key);
+	if (it == m_index.end()) {
+		return;
+	}
+	m_usage = m_usage - it->second->bytes + bytes;
+	it->second->bytes = bytes;
+	evict();
+}
+
+void AssetCache::setBudget(size_t budget)
+{
+	m_budget = budget;
+	evict();
+}
+
+void AssetCache::clear()
+{
+	m_index.clear();
+	m_entries.clear();
+	m_usage = 0;
+}
+
+void AssetCache::evict()
+{
+	while (m_usage > m_budget && m_entries.size() > 1) {
+		const Entry& entry = m_entries.back();
+		m_usage -= entry.bytes;
+		m_index.erase(entry.key);
+		m_entries.pop_back();
+	}
+}
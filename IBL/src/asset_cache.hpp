@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// ·ĳפԴ棬ܴСԤʱʹõ˳̭
+// ԴͷţɾGLshared_ptrdeleter𣬱̭ʱʹõԴһͷźɾ
+class AssetCache
+{
+public:
+	explicit AssetCache(size_t budget = 0);
+
+	// ʱԴƵʹõλãûʱnullptrͬһֻܴͬһ
+	template<typename T> std::shared_ptr<T> find(const std::string& key)
+	{
+		return std::static_pointer_cast<T>(findAsset(key));
+	}
+	// ͬһʱ滻Ԥ̭ʹõһǱ
+	void insert(const std::string& key, const std::shared_ptr<void>& asset, size_t bytes);
+	// ԴС仯ʱͼʽɣ¼¼ֽıʹ˳ûʱ
+	void resize(const std::string& key, size_t bytes);
+	void setBudget(size_t budget);
+	void clear();
+
+	size_t budget() const { return m_budget; }
+	size_t usage() const { return m_usage; }
+	size_t count() const { return m_entries.size(); }
+
+private:
+	struct Entry
+	{
+		std::string key;
+		std::shared_ptr<void> asset;
+		size_t bytes;
+	};
+
+	std::shared_ptr<void> findAsset(const std::string& key);
+	void evict();
+
+	size_t m_budget;
+	size_t m_usage;
+	// ͷʹõԴ
+	std::list<Entry> m_entries;
+	std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+};
@@ -0,0 +1,495 @@
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include "baker.hpp"
+#include "image.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+	const float PI = 3.141592f;
+	const float TwoPI = 2 * PI;
+	const float Epsilon = 0.00001f;
+	// equirectתcube mapʱÿĵ0ֿСֱֿӼɸСmipmap
+	const int ConvertTileSize = 32;
+	// ÿÿĳ
+	const int MaxSupersampling = 8;
+
+	float radicalInverse(uint32_t bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+	}
+
+	float ndfGGX(float NdotH, float roughness)
+	{
+		float alpha = roughness * roughness;
+		float alphaSq = alpha * alpha;
+
+		float denom = (NdotH * NdotH) * (alphaSq - 1.0f) + 1.0f;
+		return alphaSq / (PI * denom * denom);
+	}
+
+	// 8ͬʱcube mapĳһ˫ԲҪһ
+	// GLcube mapѡһ£ıԵclamp޷ˣ
+	void sampleLevel8(const CubeMap& cube, int level, const simd::float8 dir[3], simd::float8 rgb[3])
+	{
+		using namespace simd;
+
+		const int size = cube.size(level);
+		const float* pixels = cube.level(level);
+		const float8 zero(0.0f);
+
+		const float8 ax = abs(dir[0]), ay = abs(dir[1]), az = abs(dir[2]);
+		const float8 xMajor = (ax >= ay) & (ax >= az);
+		const float8 yMajor = ay >= az;
+
+		// ȰZΪᣬYX
+		const float8 zPositive = dir[2] > zero;
+		float8 face = select(zPositive, float8(4.0f), float8(5.0f));
+		float8 ma = az;
+		float8 sc = select(zPositive, dir[0], -dir[0]);
+		float8 tc = -dir[1];
+
+		const float8 yPositive = dir[1] > zero;
+		face = select(yMajor, select(yPositive, float8(2.0f), float8(3.0f)), face);
+		ma = select(yMajor, ay, ma);
+		sc = select(yMajor, dir[0], sc);
+		tc = select(yMajor, select(yPositive, dir[2], -dir[2]), tc);
+
+		const float8 xPositive = dir[0] > zero;
+		face = select(xMajor, select(xPositive, float8(0.0f), float8(1.0f)), face);
+		ma = select(xMajor, ax, ma);
+		sc = select(xMajor, select(xPositive, -dir[2], dir[2]), sc);
+		tc = select(xMajor, -dir[1], tc);
+
+		const float8 scale = float8(0.5f * size) / ma;
+		const float8 maxCoord(float(size - 1));
+		float8 x = min(max(fmadd(sc, scale, float8(0.5f * size - 0.5f)), zero), maxCoord);
+		float8 y = min(max(fmadd(tc, scale, float8(0.5f * size - 0.5f)), zero), maxCoord);
+
+		const float8 x0f = floor(x), y0f = floor(y);
+		const float8 fx = x - x0f, fy = y - y0f;
+		const int8 x0 = toInt(x0f), y0 = toInt(y0f);
+		const int8 x1 = min(x0 + int8(1), int8(size - 1));
+		const int8 y1 = min(y0 + int8(1), int8(size - 1));
+
+		const int8 channels(CubeMap::NumChannels);
+		const int8 faceBase = toInt(face) * int8(size * size);
+		const int8 row0 = faceBase + y0 * int8(size);
+		const int8 row1 = faceBase + y1 * int8(size);
+		const int8 i00 = (row0 + x0) * channels, i01 = (row0 + x1) * channels;
+		const int8 i10 = (row1 + x0) * channels, i11 = (row1 + x1) * channels;
+
+		for (int c = 0; c < 3; ++c) {
+			const float* base = pixels + c;
+			const float8 top = fmadd(gather(base, i01) - gather(base, i00), fx, gather(base, i00));
+			const float8 bottom = fmadd(gather(base, i11) - gather(base, i10), fx, gather(base, i10));
+			rgb[c] = fmadd(bottom - top, fy, top);
+		}
+	}
+
+	// һ8ΪһԤ˲TBNcs_prefilter.glslһ
+	void prefilterTexels8(const CubeMap& unfiltered, const IBLBaker::PrefilterSampleTable& table,
+		int face, int y, int x0, int size, float* dst)
+	{
+		using namespace simd;
+
+		float nx[Width], ny[Width], nz[Width];
+		float tx[Width], ty[Width], tz[Width];
+		float bx[Width], by[Width], bz[Width];
+		for (int lane = 0; lane < Width; ++lane) {
+			const int x = glm::min(x0 + lane, size - 1);
+			const glm::vec3 N = CubeMap::texelDirection(face, (x + 0.5f) / size, (y + 0.5f) / size);
+			glm::vec3 T = glm::cross(N, glm::vec3(0.0f, 1.0f, 0.0f));
+			if (glm::dot(T, T) < Epsilon) {
+				T = glm::cross(N, glm::vec3(1.0f, 0.0f, 0.0f));
+			}
+			T = glm::normalize(T);
+			const glm::vec3 B = glm::normalize(glm::cross(N, T));
+			nx[lane] = N.x; ny[lane] = N.y; nz[lane] = N.z;
+			tx[lane] = T.x; ty[lane] = T.y; tz[lane] = T.z;
+			bx[lane] = B.x; by[lane] = B.y; bz[lane] = B.z;
+		}
+		const float8 N[3] = { float8::load(nx), float8::load(ny), float8::load(nz) };
+		const float8 T[3] = { float8::load(tx), float8::load(ty), float8::load(tz) };
+		const float8 B[3] = { float8::load(bx), float8::load(by), float8::load(bz) };
+
+		const int maxLevel = unfiltered.levels() - 1;
+		float8 color[3] = { float8(0.0f), float8(0.0f), float8(0.0f) };
+		for (const IBLBaker::PrefilterSample& sample : table.samples) {
+			// ߿ռ䵽ռ䣨xӦByӦT
+			float8 L[3];
+			for (int c = 0; c < 3; ++c) {
+				L[c] = fmadd(B[c], float8(sample.direction.x), fmadd(T[c], float8(sample.direction.y), N[c] * float8(sample.direction.z)));
+			}
+
+			// ͬһϵmipmap㼶ͬԲֵǱ
+			const int level0 = int(sample.lod);
+			const float frac = sample.lod - float(level0);
+			float8 rgb[3];
+			sampleLevel8(unfiltered, level0, L, rgb);
+			if (frac > 0.0f && level0 < maxLevel) {
+				float8 rgb1[3];
+				sampleLevel8(unfiltered, level0 + 1, L, rgb1);
+				for (int c = 0; c < 3; ++c) {
+					rgb[c] = fmadd(rgb1[c] - rgb[c], float8(frac), rgb[c]);
+				}
+			}
+			for (int c = 0; c < 3; ++c) {
+				color[c] = fmadd(rgb[c], float8(sample.direction.z), color[c]);
+			}
+		}
+
+		float out[3][Width];
+		for (int c = 0; c < 3; ++c) {
+			(color[c] * float8(table.invWeight)).store(out[c]);
+		}
+		const int count = glm::min(Width, size - x0);
+		float* row = dst + (size_t(y) * size + x0) * CubeMap::NumChannels;
+		for (int lane = 0; lane < count; ++lane) {
+			row[lane * CubeMap::NumChannels + 0] = out[0][lane];
+			row[lane * CubeMap::NumChannels + 1] = out[1][lane];
+			row[lane * CubeMap::NumChannels + 2] = out[2][lane];
+			row[lane * CubeMap::NumChannels + 3] = 1.0f;
+		}
+	}
+
+	// CubeMap::texelDirectionͬĸ淽δһuvxuvy[-1,1]uvy
+	void faceDirection8(int face, const simd::float8& uvx, const simd::float8& uvy, simd::float8 d[3])
+	{
+		const simd::float8 one(1.0f);
+		switch (face) {
+		case 0: d[0] = one; d[1] = uvy; d[2] = -uvx; break;
+		case 1: d[0] = -one; d[1] = uvy; d[2] = uvx; break;
+		case 2: d[0] = uvx; d[1] = one; d[2] = -uvy; break;
+		case 3: d[0] = uvx; d[1] = -one; d[2] = uvy; break;
+		case 4: d[0] = uvx; d[1] = uvy; d[2] = one; break;
+		default: d[0] = -uvx; d[1] = uvy; d[2] = -one; break;
+		}
+	}
+
+	// equirect˫Բ(u, t)Ϊλˮƽƣֱclamp
+	// ֧RGB floatRGB9E5RGB9E5ÿֻҪһgather
+	void sampleEquirect8(const Image& equirect, const simd::float8& u, const simd::float8& t, simd::float8 rgb[3])
+	{
+		using namespace simd;
+
+		const float width = float(equirect.width());
+		const float8 zero(0.0f), one(1.0f);
+		const float8 x0f = floor(u), y0f = floor(t);
+		const float8 fx = u - x0f, fy = t - y0f;
+		const float8 xa = select(x0f < zero, x0f + float8(width), x0f);
+		const float8 xb = select(xa + one >= float8(width), xa + one - float8(width), xa + one);
+		const float8 maxY(float(equirect.height() - 1));
+		const int8 row0 = toInt(min(max(y0f, zero), maxY)) * int8(equirect.width());
+		const int8 row1 = toInt(min(max(y0f + one, zero), maxY)) * int8(equirect.width());
+		const int8 x0 = toInt(xa), x1 = toInt(xb);
+		int8 i00 = row0 + x0, i01 = row0 + x1, i10 = row1 + x0, i11 = row1 + x1;
+
+		float8 c00[3], c01[3], c10[3], c11[3];
+		if (equirect.format() == Image::Format::RGB9E5) {
+			const int32_t* pixels = equirect.pixels<int32_t>();
+			unpackRGB9E5(gather(pixels, i00), c00);
+			unpackRGB9E5(gather(pixels, i01), c01);
+			unpackRGB9E5(gather(pixels, i10), c10);
+			unpackRGB9E5(gather(pixels, i11), c11);
+		}
+		else {
+			const int8 channels(equirect.channels());
+			i00 = i00 * channels; i01 = i01 * channels;
+			i10 = i10 * channels; i11 = i11 * channels;
+			for (int c = 0; c < 3; ++c) {
+				const float* base = equirect.pixels<float>() + c;
+				c00[c] = gather(base, i00);
+				c01[c] = gather(base, i01);
+				c10[c] = gather(base, i10);
+				c11[c] = gather(base, i11);
+			}
+		}
+		for (int c = 0; c < 3; ++c) {
+			const float8 top = fmadd(c01[c] - c00[c], fx, c00[c]);
+			const float8 bottom = fmadd(c11[c] - c10[c], fx, c10[c]);
+			rgb[c] = fmadd(bottom - top, fy, top);
+		}
+	}
+
+	// 0ϴ(x0, y0)ʼtile x tileֿ飬ÿ串ǵķΧھȵȡsamples x samplesƽ
+	// ɺڷֿڼɸСmipmap
+	void convertTile(const Image& equirect, CubeMap& cube, int face, int x0, int y0, int tile, int samples)
+	{
+		using namespace simd;
+
+		const int size = cube.size();
+		const float invSamples = 1.0f / samples;
+		const float8 weight(invSamples * invSamples);
+		const float8 uScale(equirect.width() / TwoPI), tScale(equirect.height() / PI);
+		const float8 half(0.5f);
+
+		for (int y = y0; y < y0 + tile; ++y) {
+			float* dst = cube.face(0, face) + size_t(y) * size * CubeMap::NumChannels;
+			for (int x = x0; x < x0 + tile; x += Width) {
+				const float8 lane = laneIndex() + float8(float(x));
+				float8 color[3] = { float8(0.0f), float8(0.0f), float8(0.0f) };
+				for (int j = 0; j < samples; ++j) {
+					const float uvy = 1.0f - 2.0f * (y + (j + 0.5f) * invSamples) / size;
+					for (int i = 0; i < samples; ++i) {
+						const float8 uvx = (lane + float8((i + 0.5f) * invSamples)) * float8(2.0f / size) - float8(1.0f);
+						float8 d[3];
+						faceDirection8(face, uvx, float8(uvy), d);
+
+						// תΪ漫꣬תΪΪλ
+						const float8 invLength = float8(1.0f) / sqrt(fmadd(uvx, uvx, float8(1.0f + uvy * uvy)));
+						const float8 phi = atan2(d[2], d[0]);
+						const float8 theta = acos(d[1] * invLength);
+						float8 rgb[3];
+						sampleEquirect8(equirect, fmadd(phi, uScale, -half), fmadd(theta, tScale, -half), rgb);
+						for (int c = 0; c < 3; ++c) {
+							color[c] = color[c] + rgb[c];
+						}
+					}
+				}
+
+				float out[3][Width];
+				for (int c = 0; c < 3; ++c) {
+					(color[c] * weight).store(out[c]);
+				}
+				const int count = glm::min(Width, x0 + tile - x);
+				for (int lane = 0; lane < count; ++lane) {
+					dst[(x + lane) * CubeMap::NumChannels + 0] = out[0][lane];
+					dst[(x + lane) * CubeMap::NumChannels + 1] = out[1][lane];
+					dst[(x + lane) * CubeMap::NumChannels + 2] = out[2][lane];
+					dst[(x + lane) * CubeMap::NumChannels + 3] = 1.0f;
+				}
+			}
+		}
+
+		for (int level = 1; (tile >> level) > 0 && level < cube.levels(); ++level) {
+			cube.downsample(level, face, x0 >> level, y0 >> level, tile >> level, tile >> level);
+		}
+	}
+
+	// ʵгl <= 2Ҫһ
+	void evaluateSH8(const simd::float8 dir[3], simd::float8 basis[IBLBaker::NumSHCoefficients])
+	{
+		using namespace simd;
+		const float8& x = dir[0];
+		const float8& y = dir[1];
+		const float8& z = dir[2];
+
+		basis[0] = float8(0.282095f);
+		basis[1] = float8(0.488603f) * y;
+		basis[2] = float8(0.488603f) * z;
+		basis[3] = float8(0.488603f) * x;
+		basis[4] = float8(1.092548f) * x * y;
+		basis[5] = float8(1.092548f) * y * z;
+		basis[6] = float8(0.315392f) * fmadd(float8(3.0f) * z, z, float8(-1.0f));
+		basis[7] = float8(1.092548f) * x * z;
+		basis[8] = float8(0.546274f) * (x * x - y * y);
+	}
+
+	// һضгϵĹףһΪ֮
+	using SHRowSums = std::array<double, IBLBaker::NumSHCoefficients * 3 + 1>;
+
+	SHRowSums projectSHRow(const CubeMap& cube, int level, int face, int y)
+	{
+		using namespace simd;
+
+		const int size = cube.size(level);
+		const float* src = cube.face(level, face) + size_t(y) * size * CubeMap::NumChannels;
+		const float uvy = 1.0f - 2.0f * (y + 0.5f) / size;
+		// [-1,1]^2ϵ
+		const float texelArea = (2.0f / size) * (2.0f / size);
+
+		float8 sums[IBLBaker::NumSHCoefficients][3];
+		for (int k = 0; k < IBLBaker::NumSHCoefficients; ++k) {
+			sums[k][0] = sums[k][1] = sums[k][2] = float8(0.0f);
+		}
+		float8 solidAngleSum(0.0f);
+
+		for (int x0 = 0; x0 < size; x0 += Width) {
+			const float8 lane = laneIndex() + float8(float(x0));
+			const float8 valid = lane < float8(float(size));
+			const float8 uvx = (lane + float8(0.5f)) * float8(2.0f / size) - float8(1.0f);
+
+			float8 d[3];
+			faceDirection8(face, uvx, float8(uvy), d);
+			const float8 invLength = float8(1.0f) / sqrt(fmadd(uvx, uvx, float8(1.0f + uvy * uvy)));
+			for (int c = 0; c < 3; ++c) {
+				d[c] = d[c] * invLength;
+			}
+			// ضӦ dA / (1 + u^2 + v^2)^(3/2)
+			const float8 solidAngle = select(valid, float8(texelArea) * invLength * invLength * invLength, float8(0.0f));
+
+			float rgb[3][Width] = {};
+			const int count = glm::min(Width, size - x0);
+			for (int i = 0; i < count; ++i) {
+				const float* p = src + (x0 + i) * CubeMap::NumChannels;
+				rgb[0][i] = p[0];
+				rgb[1][i] = p[1];
+				rgb[2][i] = p[2];
+			}
+			const float8 radiance[3] = {
+				float8::load(rgb[0]) * solidAngle,
+				float8::load(rgb[1]) * solidAngle,
+				float8::load(rgb[2]) * solidAngle
+			};
+
+			float8 basis[IBLBaker::NumSHCoefficients];
+			evaluateSH8(d, basis);
+			for (int k = 0; k < IBLBaker::NumSHCoefficients; ++k) {
+				for (int c = 0; c < 3; ++c) {
+					sums[k][c] = fmadd(basis[k], radiance[c], sums[k][c]);
+				}
+			}
+			solidAngleSum = solidAngleSum + solidAngle;
+		}
+
+		SHRowSums result;
+		for (int k = 0; k < IBLBaker::NumSHCoefficients; ++k) {
+			for (int c = 0; c < 3; ++c) {
+				result[k * 3 + c] = reduceAdd(sums[k][c]);
+			}
+		}
+		result.back() = reduceAdd(solidAngleSum);
+		return result;
+	}
+}
+
+std::shared_ptr<CubeMap> IBLBaker::equirectToCube(const std::shared_ptr<Image>& source, int size)
+{
+	if (!source->isHDR() || source->channels() < 3) {
+		throw std::runtime_error("Equirectangular map must be an RGB HDR image");
+	}
+	// halfûжӦgatherתΪfloat
+	const std::shared_ptr<Image> equirect = (source->format() == Image::Format::Float16) ? source->convert(Image::Format::Float32) : source;
+
+	std::shared_ptr<CubeMap> cube = std::make_shared<CubeMap>(size);
+
+	// ĴһſĽǶԼΪ2/sizeequirectһصĽǶ֮Ⱦ
+	const float texelAngle = 2.0f / size;
+	const float equirectAngle = glm::min(TwoPI / equirect->width(), PI / equirect->height());
+	const int samples = glm::clamp(int(std::ceil(texelAngle / equirectAngle - 0.01f)), 1, MaxSupersampling);
+
+	const int tile = glm::min(ConvertTileSize, size);
+	const int tilesPerRow = size / tile;
+	const int tilesPerFace = tilesPerRow * tilesPerRow;
+	ThreadPool::global().parallelFor(0, CubeMap::NumFaces * tilesPerFace, [&](int index) {
+		const int face = index / tilesPerFace;
+		const int tileIndex = index % tilesPerFace;
+		convertTile(*equirect, *cube, face, (tileIndex % tilesPerRow) * tile, (tileIndex / tilesPerRow) * tile, tile, samples);
+	});
+
+	// ֿѾɵߴΪ1Ĳ㣬ʣµĲСһʽ˲
+	int firstLevel = 1;
+	while ((tile >> firstLevel) > 0) {
+		++firstLevel;
+	}
+	cube->generateMipmaps(firstLevel);
+	return cube;
+}
+
+float IBLBaker::prefilterRoughness(int level, int levels)
+{
+	return float(level) / glm::max(float(levels - 1), 1.0f);
+}
+
+IBLBaker::PrefilterSampleTable IBLBaker::buildPrefilterSamples(float roughness, int numSamples, int inputSize, int inputLevels)
+{
+	// cubemapһضӦ
+	const float saTexel = 4.0f * PI / (6.0f * inputSize * inputSize);
+	const float alpha = roughness * roughness;
+
+	PrefilterSampleTable table;
+	table.samples.reserve(numSamples);
+	float weight = 0.0f;
+	for (int i = 0; i < numSamples; ++i) {
+		const float u = float(i) / float(numSamples);
+		const float v = radicalInverse(uint32_t(i));
+
+		const float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+		const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+		const float phi = TwoPI * u;
+		const glm::vec3 h(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+		const glm::vec3 L = 2.0f * h.z * h - glm::vec3(0.0f, 0.0f, 1.0f);
+
+		// NdotL <= 0 ĲȨΪ0ֱ޳
+		const float NdotL = L.z;
+		if (NdotL > 0.0f) {
+			// ˴ʹ Krivanek  Pre-filtered importance sampling
+			const float NdotH = glm::max(h.z, 0.0f);
+			const float HdotV = NdotH;
+			const float pdf = ndfGGX(NdotH, roughness) * NdotH / (4.0f * HdotV) + Epsilon;
+			const float saSample = 1.0f / (float(numSamples) * pdf + Epsilon);
+			const float lod = roughness == 0.0f ? 0.0f : 0.5f * std::log2(saSample / saTexel);
+			table.samples.push_back({ L, glm::clamp(lod, 0.0f, float(inputLevels - 1)) });
+			weight += NdotL;
+		}
+	}
+	// V = N ʱصȨ֮Ͷͬ
+	table.invWeight = weight > 0.0f ? 1.0f / weight : 0.0f;
+	return table;
+}
+
+std::shared_ptr<CubeMap> IBLBaker::prefilter(const CubeMap& unfiltered, int numSamples)
+{
+	std::shared_ptr<CubeMap> result = std::make_shared<CubeMap>(unfiltered.size(), unfiltered.levels());
+	std::memcpy(result->level(0), unfiltered.level(0), unfiltered.levelSize(0) * sizeof(float));
+
+	for (int level = 1; level < result->levels(); ++level) {
+		const PrefilterSampleTable table = buildPrefilterSamples(prefilterRoughness(level, result->levels()), numSamples, unfiltered.size(), unfiltered.levels());
+
+		const int size = result->size(level);
+		ThreadPool::global().parallelFor(0, CubeMap::NumFaces * size, [&](int row) {
+			const int face = row / size;
+			const int y = row % size;
+			for (int x = 0; x < size; x += simd::Width) {
+				prefilterTexels8(unfiltered, table, face, y, x, size, result->face(level, face));
+			}
+		});
+	}
+	return result;
+}
+
+IBLBaker::SHCoefficients IBLBaker::projectSH(const CubeMap& cube)
+{
+	int level = 0;
+	while (cube.size(level) > SHProjectionSize && level + 1 < cube.levels()) {
+		++level;
+	}
+
+	const int size = cube.size(level);
+	std::vector<SHRowSums> rows(CubeMap::NumFaces * size);
+	ThreadPool::global().parallelFor(0, CubeMap::NumFaces * size, [&](int row) {
+		rows[row] = projectSHRow(cube, level, row / size, row % size);
+	});
+
+	// ˳ۼӣ֤߳޹
+	SHRowSums total = {};
+	for (const SHRowSums& row : rows) {
+		for (size_t i = 0; i < total.size(); ++i) {
+			total[i] += row[i];
+		}
+	}
+
+	// Һ˾׵ϵ A_l / PI1, 2/3, 1/4ͬʱ֮Ϊ4PI
+	const double bandFactor[3] = { 1.0, 2.0 / 3.0, 0.25 };
+	const double normalization = 4.0 * 3.14159265358979 / total.back();
+
+	SHCoefficients coefficients;
+	for (int k = 0; k < NumSHCoefficients; ++k) {
+		const int band = (k == 0) ? 0 : (k < 4 ? 1 : 2);
+		const double factor = normalization * bandFactor[band];
+		coefficients[k] = glm::vec4(float(total[k * 3 + 0] * factor), float(total[k * 3 + 1] * factor), float(total[k * 3 + 2] * factor), 0.0f);
+	}
+	return coefficients;
+}
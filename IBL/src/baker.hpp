@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vector>
+
+#include "cubemap.hpp"
+
+class Image;
+
+// IBLԤCPUʵ֣data/shadersµļɫһһӦ
+// ȫ̳߳УҪOpenGL
+class IBLBaker
+{
+public:
+	// cs_prefilter.glslеNumSamplesһ
+	static const int PrefilterSamples = 1024;
+	static const int NumSHCoefficients = 9;
+	// ͶӰгʱʹõmipmapߴ磬ֻҪƵϢ
+	static const int SHProjectionSize = 64;
+
+	// L2гϵrgbЧҺ˾PIɫֱͼõ irradiance / PI
+	using SHCoefficients = std::array<glm::vec4, NumSHCoefficients>;
+
+	// Ԥ˲һ߿ռ(N = (0,0,1))µ䷽LԼmipmap㼶NdotLdirection.z
+	// Ϊ V = NЩֲֻڶйأعãcs_prefilter.glslеSample(std430)һ
+	struct PrefilterSample
+	{
+		glm::vec3 direction;
+		float lod;
+	};
+
+	// ĳֲڶȵĲ޳NdotL <= 0ĲinvWeightΪ 1 / sum(NdotL)
+	struct PrefilterSampleTable
+	{
+		std::vector<PrefilterSample> samples;
+		float invWeight;
+	};
+
+	// levelmipmapԤ˲ʹõĴֲڶȣ0Ϊԭͼ
+	static float prefilterRoughness(int level, int levels);
+	// inputSizeinputLevelsΪδԤ˲cube mapĳߴmipmap
+	static PrefilterSampleTable buildPrefilterSamples(float roughness, int numSamples, int inputSize, int inputLevels);
+
+	// equirectangularͶӰcube mapÿequirectϰǷΧͬʱmipmap
+	// equirectfloathalfRGB9E5ʽ
+	static std::shared_ptr<CubeMap> equirectToCube(const std::shared_ptr<Image>& equirect, int size);
+
+	// cs_prefilter.glsl0ֱӸƣ1..N㰴 roughness = level / N GGXԤ˲GPU
+	// unfilteredҪmipmapPre-filtered importance sampling
+	static std::shared_ptr<CubeMap> prefilter(const CubeMap& unfiltered, int numSamples = PrefilterSamples);
+
+	// cs_sh_project.glsl + cs_sh_reduce.glslѻͶӰL2гԭirradiance map
+	// ʹòSHProjectionSizeһmipmap
+	static SHCoefficients projectSH(const CubeMap& cube);
+};
@@ -0,0 +1,694 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "block_compressor.hpp"
+#include "image.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+	// mode 64λӦĲֵȨأ/64
+	const int BC7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+	// λ¶˵Ĵ
+	const int RefineIterations[] = { 1, 3, 5 };
+	// BC6Hhalfλģʽֵڲ16λֵΪλģʽ64/31ֵΪ0x7BFF
+	const float BC6HScale = 64.0f / 31.0f;
+	const float BC6HMax = 65535.0f;
+
+	// BC6Hĵģʽ5λģʽš˵㾫ȡڶ˵λ0ʾֱӴ洢
+	struct BC6HMode
+	{
+		uint32_t bits;
+		int precision;
+		int deltaBits;
+	};
+	const BC6HMode BC6HModes[] = {
+		{ 0x03, 10, 0 },	// mode 11
+		{ 0x07, 11, 9 },	// mode 12
+		{ 0x0B, 12, 8 },	// mode 13
+		{ 0x0F, 16, 4 },	// mode 14
+	};
+
+	// 4x4أͼûеͨalphaΪ255Ϊ0
+	struct Block
+	{
+		float pixels[16][4];
+	};
+
+	// 鳬ͼԵʱظһ/
+	void loadBlock(const Image& image, int bx, int by, Block& block)
+	{
+		const int channels = image.channels();
+		const unsigned char* pixels = image.pixels<unsigned char>();
+		for (int i = 0; i < 16; ++i) {
+			const int x = std::min(bx * 4 + (i & 3), image.width() - 1);
+			const int y = std::min(by * 4 + (i >> 2), image.height() - 1);
+			const unsigned char* p = pixels + size_t(y) * image.pitch() + size_t(x) * channels;
+			for (int c = 0; c < 4; ++c) {
+				block.pixels[i][c] = c < channels ? float(p[c]) : (c == 3 ? 255.0f : 0.0f);
+			}
+		}
+	}
+
+	// λӵ͵д16ֽڵĿ
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(uint8_t* out)
+			: m_out(out)
+			, m_position(0)
+		{
+			std::memset(out, 0, 16);
+		}
+
+		void write(uint32_t value, int bits)
+		{
+			for (int i = 0; i < bits; ++i, ++m_position) {
+				if ((value >> i) & 1u) {
+					m_out[m_position >> 3] |= uint8_t(1u << (m_position & 7));
+				}
+			}
+		}
+
+	private:
+		uint8_t* m_out;
+		int m_position;
+	};
+
+	// halfͼĿ飬Žֵõ16λֵȡ0NaNȡֵ
+	void loadHalfBlock(const Image& image, int bx, int by, Block& block)
+	{
+		const int channels = image.channels();
+		const uint16_t* pixels = image.pixels<uint16_t>();
+		for (int i = 0; i < 16; ++i) {
+			const int x = std::min(bx * 4 + (i & 3), image.width() - 1);
+			const int y = std::min(by * 4 + (i >> 2), image.height() - 1);
+			const uint16_t* p = pixels + (size_t(y) * image.width() + x) * channels;
+			for (int c = 0; c < 3; ++c) {
+				const int bits = (p[c] & 0x8000) ? 0 : std::min(int(p[c]), 0x7BFF);
+				block.pixels[i][c] = bits * BC6HScale;
+			}
+			block.pixels[i][3] = 0.0f;
+		}
+	}
+
+	// ǰnͨᣨЭݵԼ˵Ķ˵㣬ͨ[0, maxValue]
+	void initialEndpoints(const Block& block, int n, float maxValue, float e0[4], float e1[4])
+	{
+		float mean[4] = {};
+		for (int i = 0; i < 16; ++i) {
+			for (int c = 0; c < n; ++c) {
+				mean[c] += block.pixels[i][c] / 16.0f;
+			}
+		}
+
+		float covariance[4][4] = {};
+		for (int i = 0; i < 16; ++i) {
+			for (int a = 0; a < n; ++a) {
+				for (int b = 0; b < n; ++b) {
+					covariance[a][b] += (block.pixels[i][a] - mean[a]) * (block.pixels[i][b] - mean[b]);
+				}
+			}
+		}
+
+		// ӷͨʼ
+		int largest = 0;
+		for (int c = 1; c < n; ++c) {
+			if (covariance[c][c] > covariance[largest][largest]) {
+				largest = c;
+			}
+		}
+		float axis[4] = {};
+		for (int c = 0; c < n; ++c) {
+			axis[c] = covariance[largest][c];
+		}
+		for (int iteration = 0; iteration < 8; ++iteration) {
+			float next[4] = {};
+			float scale = 0.0f;
+			for (int a = 0; a < n; ++a) {
+				for (int b = 0; b < n; ++b) {
+					next[a] += covariance[a][b] * axis[b];
+				}
+				scale = std::max(scale, std::fabs(next[a]));
+			}
+			if (scale <= 0.0f) {
+				break;
+			}
+			for (int c = 0; c < n; ++c) {
+				axis[c] = next[c] / scale;
+			}
+		}
+		float length = 0.0f;
+		for (int c = 0; c < n; ++c) {
+			length += axis[c] * axis[c];
+		}
+		length = std::sqrt(length);
+
+		float tMin = 0.0f, tMax = 0.0f;
+		if (length > 0.0f) {
+			for (int c = 0; c < n; ++c) {
+				axis[c] /= length;
+			}
+			tMin = FLT_MAX;
+			tMax = -FLT_MAX;
+			for (int i = 0; i < 16; ++i) {
+				float t = 0.0f;
+				for (int c = 0; c < n; ++c) {
+					t += (block.pixels[i][c] - mean[c]) * axis[c];
+				}
+				tMin = std::min(tMin, t);
+				tMax = std::max(tMax, t);
+			}
+		}
+		for (int c = 0; c < 4; ++c) {
+			e0[c] = std::min(std::max(mean[c] + tMin * axis[c], 0.0f), maxValue);
+			e1[c] = std::min(std::max(mean[c] + tMax * axis[c], 0.0f), maxValue);
+		}
+	}
+
+	// ֪˵֮ĲֵȨأ˵1ռıСǰnͨĶ˵
+	bool solveEndpoints(const Block& block, int n, float maxValue, const float weights[16], float e0[4], float e1[4])
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for (int i = 0; i < 16; ++i) {
+			const float a = 1.0f - weights[i], b = weights[i];
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for (int c = 0; c < n; ++c) {
+				ax[c] += a * block.pixels[i][c];
+				bx[c] += b * block.pixels[i][c];
+			}
+		}
+		const float determinant = aa * bb - ab * ab;
+		if (std::fabs(determinant) < 1e-6f) {
+			return false;
+		}
+		for (int c = 0; c < n; ++c) {
+			e0[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) / determinant, 0.0f), maxValue);
+			e1[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) / determinant, 0.0f), maxValue);
+		}
+		return true;
+	}
+
+	uint16_t pack565(const float color[4])
+	{
+		const int r = int(color[0] * 31.0f / 255.0f + 0.5f);
+		const int g = int(color[1] * 63.0f / 255.0f + 0.5f);
+		const int b = int(color[2] * 31.0f / 255.0f + 0.5f);
+		return uint16_t((r << 11) | (g << 5) | b);
+	}
+
+	void unpack565(uint16_t value, float color[4])
+	{
+		const int r = (value >> 11) & 31, g = (value >> 5) & 63, b = value & 31;
+		color[0] = float((r << 3) | (r >> 2));
+		color[1] = float((g << 2) | (g >> 4));
+		color[2] = float((b << 3) | (b >> 2));
+	}
+
+	float encodeBC1(const Block& block, int iterations, uint8_t* out)
+	{
+		// ˵1ռı01Ϊ˵㣬23Ϊ1/32/3
+		const float indexWeights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+		float e0[4], e1[4];
+		initialEndpoints(block, 3, 255.0f, e0, e1);
+
+		float bestError = FLT_MAX;
+		for (int iteration = 0; iteration < iterations; ++iteration) {
+			// 4ɫģʽҪcolor0 > color1ʱʹ0
+			uint16_t c0 = pack565(e1), c1 = pack565(e0);
+			if (c0 < c1) {
+				std::swap(c0, c1);
+			}
+			float palette[4][4];
+			unpack565(c0, palette[0]);
+			unpack565(c1, palette[1]);
+			for (int c = 0; c < 3; ++c) {
+				palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+				palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+			}
+			const int numColors = (c0 == c1) ? 1 : 4;
+
+			uint32_t indices = 0;
+			float weights[16];
+			float error = 0.0f;
+			for (int i = 0; i < 16; ++i) {
+				int bestIndex = 0;
+				float bestDistance = FLT_MAX;
+				for (int k = 0; k < numColors; ++k) {
+					float distance = 0.0f;
+					for (int c = 0; c < 3; ++c) {
+						const float d = block.pixels[i][c] - palette[k][c];
+						distance += d * d;
+					}
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						bestIndex = k;
+					}
+				}
+				indices |= uint32_t(bestIndex) << (2 * i);
+				weights[i] = indexWeights[bestIndex];
+				error += bestDistance;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				out[0] = uint8_t(c0);
+				out[1] = uint8_t(c0 >> 8);
+				out[2] = uint8_t(c1);
+				out[3] = uint8_t(c1 >> 8);
+				std::memcpy(out + 4, &indices, 4);
+			}
+			if (numColors == 1 || !solveEndpoints(block, 3, 255.0f, weights, e0, e1)) {
+				break;
+			}
+			// color0color1˳һpackʱe1Ӧcolor0
+			std::swap(e0, e1);
+		}
+		return bestError;
+	}
+
+	float encodeBC4(const Block& block, int channel, uint8_t* out)
+	{
+		int lo = 255, hi = 0;
+		for (int i = 0; i < 16; ++i) {
+			const int value = int(block.pixels[i][channel]);
+			lo = std::min(lo, value);
+			hi = std::max(hi, value);
+		}
+
+		// ڰΧΧСΧ˵㣬8ֵģʽҪr0 > r1
+		float bestError = FLT_MAX;
+		for (int r0 = hi; r0 >= std::max(hi - 2, lo); --r0) {
+			for (int r1 = lo; r1 <= std::min(lo + 2, r0); ++r1) {
+				float palette[8] = { float(r0), float(r1) };
+				for (int k = 2; k < 8; ++k) {
+					palette[k] = ((8 - k) * r0 + (k - 1) * r1) / 7.0f;
+				}
+				const int numValues = (r0 > r1) ? 8 : 1;
+
+				uint64_t indices = 0;
+				float error = 0.0f;
+				for (int i = 0; i < 16; ++i) {
+					int bestIndex = 0;
+					float bestDistance = FLT_MAX;
+					for (int k = 0; k < numValues; ++k) {
+						const float d = block.pixels[i][channel] - palette[k];
+						if (d * d < bestDistance) {
+							bestDistance = d * d;
+							bestIndex = k;
+						}
+					}
+					indices |= uint64_t(bestIndex) << (3 * i);
+					error += bestDistance;
+				}
+
+				if (error < bestError) {
+					bestError = error;
+					out[0] = uint8_t(r0);
+					out[1] = uint8_t(r1);
+					for (int b = 0; b < 6; ++b) {
+						out[2 + b] = uint8_t(indices >> (8 * b));
+					}
+				}
+			}
+		}
+		return bestError;
+	}
+
+	// ˵Ϊ7λ1λP˵һPλȡСP
+	float quantizeBC7Endpoint(const float endpoint[4], int n, int quantized[4], int& pbit, int value[4])
+	{
+		float bestError = FLT_MAX;
+		for (int p = 0; p < 2; ++p) {
+			int q[4], v[4];
+			float error = 0.0f;
+			for (int c = 0; c < 4; ++c) {
+				q[c] = std::min(std::max(int((endpoint[c] - p) / 2.0f + 0.5f), 0), 127);
+				v[c] = (q[c] << 1) | p;
+				if (c < n) {
+					error += (endpoint[c] - v[c]) * (endpoint[c] - v[c]);
+				}
+			}
+			if (error < bestError) {
+				bestError = error;
+				pbit = p;
+				std::copy(q, q + 4, quantized);
+				std::copy(v, v + 4, value);
+			}
+		}
+		return bestError;
+	}
+
+	// BC7 mode 6ӼRGBA˵7λ+Pλ4λ
+	float encodeBC7(const Block& block, bool alpha, int iterations, uint8_t* out)
+	{
+		// Ҫalphaʱalpha˵alphaȡֵ
+		const int n = alpha ? 4 : 3;
+
+		float e0[4], e1[4];
+		initialEndpoints(block, n, 255.0f, e0, e1);
+		if (!alpha) {
+			e0[3] = e1[3] = 255.0f;
+		}
+
+		float bestError = FLT_MAX;
+		int bestQuantized[2][4] = {}, bestP[2] = {};
+		int bestIndices[16] = {};
+		for (int iteration = 0; iteration < iterations; ++iteration) {
+			int quantized[2][4], value[2][4], p[2];
+			quantizeBC7Endpoint(e0, n, quantized[0], p[0], value[0]);
+			quantizeBC7Endpoint(e1, n, quantized[1], p[1], value[1]);
+
+			int palette[16][4];
+			for (int k = 0; k < 16; ++k) {
+				for (int c = 0; c < 4; ++c) {
+					palette[k][c] = ((64 - BC7Weights[k]) * value[0][c] + BC7Weights[k] * value[1][c] + 32) >> 6;
+				}
+			}
+
+			int indices[16];
+			float weights[16];
+			float error = 0.0f;
+			for (int i = 0; i < 16; ++i) {
+				int bestIndex = 0;
+				float bestDistance = FLT_MAX;
+				for (int k = 0; k < 16; ++k) {
+					float distance = 0.0f;
+					for (int c = 0; c < n; ++c) {
+						const float d = block.pixels[i][c] - palette[k][c];
+						distance += d * d;
+					}
+					if (distance < bestDistance) {
+						bestDistance = distance;
+						bestIndex = k;
+					}
+				}
+				indices[i] = bestIndex;
+				weights[i] = BC7Weights[bestIndex] / 64.0f;
+				error += bestDistance;
+			}
+
+			if (error < bestError) {
+				bestError = error;
+				std::memcpy(bestQuantized, quantized, sizeof(quantized));
+				std::memcpy(bestP, p, sizeof(p));
+				std::memcpy(bestIndices, indices, sizeof(indices));
+			}
+			if (!solveEndpoints(block, n, 255.0f, weights, e0, e1)) {
+				break;
+			}
+		}
+
+		// һصλΪ0򽻻˵㲢ת
+		if (bestIndices[0] & 8) {
+			std::swap(bestQuantized[0], bestQuantized[1]);
+			std::swap(bestP[0], bestP[1]);
+			for (int i = 0; i < 16; ++i) {
+				bestIndices[i] = 15 - bestIndices[i];
+			}
+		}
+
+		BitWriter writer(out);
+		writer.write(1u << 6, 7);
+		for (int c = 0; c < 4; ++c) {
+			writer.write(bestQuantized[0][c], 7);
+			writer.write(bestQuantized[1][c], 7);
+		}
+		writer.write(bestP[0], 1);
+		writer.write(bestP[1], 1);
+		writer.write(bestIndices[0], 3);
+		for (int i = 1; i < 16; ++i) {
+			writer.write(bestIndices[i], 4);
+		}
+		return bestError;
+	}
+
+	int unquantizeBC6H(int value, int precision)
+	{
+		if (precision >= 15) {
+			return value;
+		}
+		if (value == 0) {
+			return 0;
+		}
+		if (value == (1 << precision) - 1) {
+			return 0xFFFF;
+		}
+		return ((value << 16) + 0x8000) >> precision;
+	}
+
+	// ȡӽֵ
+	int quantizeBC6H(float value, int precision)
+	{
+		const int maxValue = (1 << precision) - 1;
+		const int guess = std::min(std::max(int(value * float(1 << precision) / 65536.0f), 0), maxValue);
+		int best = guess;
+		for (int candidate = std::max(guess - 1, 0); candidate <= std::min(guess + 1, maxValue); ++candidate) {
+			if (std::fabs(unquantizeBC6H(candidate, precision) - value) < std::fabs(unquantizeBC6H(best, precision) - value)) {
+				best = candidate;
+			}
+		}
+		return best;
+	}
+
+	bool fitsBC6HDelta(const BC6HMode& mode, const int endpoints[2][3])
+	{
+		for (int c = 0; c < 3 && mode.deltaBits > 0; ++c) {
+			const int delta = endpoints[1][c] - endpoints[0][c];
+			if (delta < -(1 << (mode.deltaBits - 1)) || delta >= (1 << (mode.deltaBits - 1))) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// ΪõĶ˵ѡhalfλģʽϵƽͣweightsΪ(endpoints[0], endpoints[1])֮Ĳֵ
+	// һصλΪ1ʱ˵㲢תŲʱFLT_MAX
+	float evaluateBC6H(const Block& block, const BC6HMode& mode, int endpoints[2][3], int indices[16], float weights[16])
+	{
+		int unquantized[2][3];
+		for (int e = 0; e < 2; ++e) {
+			for (int c = 0; c < 3; ++c) {
+				unquantized[e][c] = unquantizeBC6H(endpoints[e][c], mode.precision);
+			}
+		}
+		float palette[16][3];
+		for (int k = 0; k < 16; ++k) {
+			for (int c = 0; c < 3; ++c) {
+				const int value = ((64 - BC7Weights[k]) * unquantized[0][c] + BC7Weights[k] * unquantized[1][c] + 32) >> 6;
+				palette[k][c] = float((value * 31) >> 6);
+			}
+		}
+
+		float error = 0.0f;
+		for (int i = 0; i < 16; ++i) {
+			int bestIndex = 0;
+			float bestDistance = FLT_MAX;
+			for (int k = 0; k < 16; ++k) {
+				float distance = 0.0f;
+				for (int c = 0; c < 3; ++c) {
+					const float d = block.pixels[i][c] / BC6HScale - palette[k][c];
+					distance += d * d;
+				}
+				if (distance < bestDistance) {
+					bestDistance = distance;
+					bestIndex = k;
+				}
+			}
+			indices[i] = bestIndex;
+			weights[i] = BC7Weights[bestIndex] / 64.0f;
+			error += bestDistance;
+		}
+
+		// ֵȨضԳƣ˵15 - iԭͬ
+		if (indices[0] & 8) {
+			std::swap(endpoints[0], endpoints[1]);
+			for (int i = 0; i < 16; ++i) {
+				indices[i] = 15 - indices[i];
+			}
+			if (!fitsBC6HDelta(mode, endpoints)) {
+				return FLT_MAX;
+			}
+		}
+		return error;
+	}
+
+	// BC6H޷ţֻʹõmode 11~14HighλųԶ˵㾫ȸߵģʽ
+	float encodeBC6H(const Block& block, BlockCompressor::Quality quality, uint8_t* out)
+	{
+		float e0[4], e1[4];
+		initialEndpoints(block, 3, BC6HMax, e0, e1);
+
+		const int numModes = (quality == BlockCompressor::Quality::High) ? 4 : 1;
+		float bestError = FLT_MAX;
+		int bestMode = 0;
+		int bestEndpoints[2][3] = {};
+		int bestIndices[16] = {};
+		for (int m = 0; m < numModes; ++m) {
+			const BC6HMode& mode = BC6HModes[m];
+			float a[4], b[4];
+			std::copy(e0, e0 + 4, a);
+			std::copy(e1, e1 + 4, b);
+			for (int iteration = 0; iteration < RefineIterations[int(quality)]; ++iteration) {
+				int endpoints[2][3];
+				for (int c = 0; c < 3; ++c) {
+					endpoints[0][c] = quantizeBC6H(a[c], mode.precision);
+					endpoints[1][c] = quantizeBC6H(b[c], mode.precision);
+					// Χʱѵڶ˵һ˵
+					if (mode.deltaBits > 0) {
+						const int range = 1 << (mode.deltaBits - 1);
+						endpoints[1][c] = endpoints[0][c] + std::min(std::max(endpoints[1][c] - endpoints[0][c], -range), range - 1);
+					}
+				}
+
+				int indices[16];
+				float weights[16];
+				const float error = evaluateBC6H(block, mode, endpoints, indices, weights);
+				if (error < bestError) {
+					bestError = error;
+					bestMode = m;
+					std::memcpy(bestEndpoints, endpoints, sizeof(endpoints));
+					std::memcpy(bestIndices, indices, sizeof(indices));
+				}
+				if (!solveEndpoints(block, 3, BC6HMax, weights, a, b)) {
+					break;
+				}
+			}
+		}
+
+		// ̶ʽģʽţһ˵ĵ10λȻÿͨĵڶ˵㣨һ˵10λĲ֣Ӹߵͣ
+		const BC6HMode& mode = BC6HModes[bestMode];
+		BitWriter writer(out);
+		writer.write(mode.bits, 5);
+		for (int c = 0; c < 3; ++c) {
+			writer.write(bestEndpoints[0][c] & 0x3FF, 10);
+		}
+		for (int c = 0; c < 3; ++c) {
+			if (mode.deltaBits == 0) {
+				writer.write(bestEndpoints[1][c], 10);
+				continue;
+			}
+			writer.write(uint32_t(bestEndpoints[1][c] - bestEndpoints[0][c]) & ((1u << mode.deltaBits) - 1), mode.deltaBits);
+			for (int bit = mode.precision - 1; bit >= 10; --bit) {
+				writer.write((bestEndpoints[0][c] >> bit) & 1, 1);
+			}
+		}
+		writer.write(bestIndices[0], 3);
+		for (int i = 1; i < 16; ++i) {
+			writer.write(bestIndices[i], 4);
+		}
+		return bestError;
+	}
+}
+
+const float BlockCompressor::MaxBC1Error = 2.0f;
+
+size_t BlockCompressor::blockBytes(CompressedTexture::Format format)
+{
+	return (format == CompressedTexture::Format::BC1 || format == CompressedTexture::Format::BC4) ? 8 : 16;
+}
+
+size_t BlockCompressor::levelBytes(CompressedTexture::Format format, int width, int height)
+{
+	return size_t((width + 3) / 4) * size_t((height + 3) / 4) * blockBytes(format);
+}
+
+std::vector<uint8_t> BlockCompressor::compressLevel(const Image& image, CompressedTexture::Format format, double* squaredError, Quality quality)
+{
+	// BC6HΪhalfͼΪ8λͼ
+	const int minChannels[] = { 3, 1, 2, 3, 3 };
+	const Image::Format sourceFormat = (format == CompressedTexture::Format::BC6H) ? Image::Format::Float16 : Image::Format::UNorm8;
+	if (image.format() != sourceFormat || image.channels() < minChannels[int(format)]) {
+		throw std::runtime_error("Unsupported image for block compression");
+	}
+
+	const int blocksX = (image.width() + 3) / 4;
+	const int blocksY = (image.height() + 3) / 4;
+	const size_t bytes = blockBytes(format);
+	std::vector<uint8_t> data(size_t(blocksX) * blocksY * bytes);
+	std::vector<double> rowErrors(blocksY, 0.0);
+	const bool alpha = image.channels() == 4;
+	const int iterations = RefineIterations[int(quality)];
+
+	ThreadPool::global().parallelFor(0, blocksY, [&](int by) {
+		Block block;
+		for (int bx = 0; bx < blocksX; ++bx) {
+			if (format == CompressedTexture::Format::BC6H) {
+				loadHalfBlock(image, bx, by, block);
+			}
+			else {
+				loadBlock(image, bx, by, block);
+			}
+			uint8_t* out = &data[(size_t(by) * blocksX + bx) * bytes];
+			switch (format) {
+			case CompressedTexture::Format::BC1:
+				rowErrors[by] += encodeBC1(block, iterations, out);
+				break;
+			case CompressedTexture::Format::BC4:
+				rowErrors[by] += encodeBC4(block, 0, out);
+				break;
+			case CompressedTexture::Format::BC5:
+				rowErrors[by] += encodeBC4(block, 0, out);
+				rowErrors[by] += encodeBC4(block, 1, out + 8);
+				break;
+			case CompressedTexture::Format::BC6H:
+				rowErrors[by] += encodeBC6H(block, quality, out);
+				break;
+			default:
+				rowErrors[by] += encodeBC7(block, alpha, iterations, out);
+				break;
+			}
+		}
+	});
+
+	if (squaredError) {
+		*squaredError = 0.0;
+		for (double error : rowErrors) {
+			*squaredError += error;
+		}
+	}
+	return data;
+}
+
+std::shared_ptr<CompressedTexture> BlockCompressor::compress(const std::vector<std::shared_ptr<Image>>& mipChain, MipGenerator::ColorSpace colorSpace)
+{
+	const Image& base = *mipChain.front();
+
+	std::shared_ptr<CompressedTexture> texture = std::make_shared<CompressedTexture>();
+	texture->srgb = colorSpace == MipGenerator::ColorSpace::SRGB;
+	texture->width = base.width();
+	texture->height = base.height();
+	texture->levels.resize(mipChain.size());
+
+	if (colorSpace == MipGenerator::ColorSpace::Normal || base.channels() == 2) {
+		texture->format = CompressedTexture::Format::BC5;
+	}
+	else if (base.channels() == 1) {
+		texture->format = CompressedTexture::Format::BC4;
+	}
+	else if (base.channels() == 4) {
+		texture->format = CompressedTexture::Format::BC7;
+	}
+	else {
+		// BC10㹻СmipmapBC1
+		double squaredError;
+		texture->levels[0] = compressLevel(base, CompressedTexture::Format::BC1, &squaredError);
+		const double rmse = std::sqrt(squaredError / (double(base.width()) * base.height() * 3));
+		texture->format = (rmse <= MaxBC1Error) ? CompressedTexture::Format::BC1 : CompressedTexture::Format::BC7;
+	}
+
+	for (size_t level = 0; level < mipChain.size(); ++level) {
+		if (level == 0 && !texture->levels[0].empty() && texture->format == CompressedTexture::Format::BC1) {
+			continue;
+		}
+		texture->levels[level] = compressLevel(*mipChain[level], texture->format);
+	}
+	return texture;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "mip_generator.hpp"
+
+class Image;
+
+// ѹͼmipmapÿ㰴4x4д
+struct CompressedTexture
+{
+	enum class Format : int32_t
+	{
+		BC1,	// RGBÿ8ֽ
+		BC4,	// ͨÿ8ֽ
+		BC5,	// ˫ͨߵxyÿ16ֽ
+		BC7,	// RGBAÿ16ֽڣֻʹmode 6
+		BC6H,	// ޷ŵRGB halfÿ16ֽڣֻʹõmode 11~14
+	};
+
+	Format format;
+	bool srgb;
+	int width;
+	int height;
+	std::vector<std::vector<uint8_t>> levels;
+};
+
+// 4x4ѹɫͼBC7BC1BC1㹻СʱѡBC1룩BC5ͨͼBC4HDRͼBC6H
+// ̳߳ϲ
+class BlockCompressor
+{
+public:
+	// ѹ˵ŻĴHighʱBC6H᳢Զ˵㾫ȸߵģʽ
+	enum class Quality
+	{
+		Fast,
+		Normal,
+		High,
+	};
+
+	// BC1ڵ0ľ8λֵʱѡBC1
+	static const float MaxBC1Error;
+
+	static size_t blockBytes(CompressedTexture::Format format);
+	static size_t levelBytes(CompressedTexture::Format format, int width, int height);
+
+	// mipChainMipGeneratorɣcolorSpaceʽNormalΪBC5ͨΪBC4ΪBC1/BC7
+	static std::shared_ptr<CompressedTexture> compress(const std::vector<std::shared_ptr<Image>>& mipChain, MipGenerator::ColorSpace colorSpace);
+
+	// ѹһͼBC6HΪhalfͼΪ8λͼ񣩣squaredErrorΪʱظͨƽ
+	// BC6Hhalfλģʽ
+	static std::vector<uint8_t> compressLevel(const Image& image, CompressedTexture::Format format, double* squaredError = nullptr, Quality quality = Quality::Normal);
+};
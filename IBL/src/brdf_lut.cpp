@@ -0,0 +1,97 @@
+#include <cmath>
+
+#include "brdf_lut.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+
+namespace
+{
+	const float PI = 3.141592f;
+	const float Epsilon = 0.001f;
+
+	float radicalInverse(uint32_t bits)
+	{
+		bits = (bits << 16u) | (bits >> 16u);
+		bits = ((bits & 0x55555555u) << 1u) | ((bits & 0xAAAAAAAAu) >> 1u);
+		bits = ((bits & 0x33333333u) << 2u) | ((bits & 0xCCCCCCCCu) >> 2u);
+		bits = ((bits & 0x0F0F0F0Fu) << 4u) | ((bits & 0xF0F0F0F0u) >> 4u);
+		bits = ((bits & 0x00FF00FFu) << 8u) | ((bits & 0xFF00FF00u) >> 8u);
+		return float(bits) * 2.3283064365386963e-10f; // / 0x100000000
+	}
+
+	simd::float8 gaSchlickG1(const simd::float8& cosTheta, const simd::float8& k)
+	{
+		return cosTheta / simd::fmadd(cosTheta, simd::float8(1.0f) - k, k);
+	}
+
+	// ԭcs_lut.glslͬĻ֣һһ8NdotV
+	// ͬһеroughnessͬԲõİH8ͨǹõ
+	void integrateTexels8(float x0, float roughness, int size, int numSamples, float* scaleOut, float* biasOut)
+	{
+		using simd::float8;
+
+		const float alpha = roughness * roughness;
+		const float8 k((roughness * roughness) / 2.0f); // EpicһĶ
+		const float8 zero(0.0f);
+		const float8 one(1.0f);
+
+		// ΪGGXиͬԣȡһV(0, 0, 1)
+		const float8 NdotV = simd::max((simd::laneIndex() + float8(x0 + 0.5f)) / float8(float(size)), float8(Epsilon));
+		const float8 Vx = simd::sqrt(one - NdotV * NdotV);
+		const float8 GV = gaSchlickG1(NdotV, k);
+
+		float8 scale = zero;
+		float8 bias = zero;
+		for (int i = 0; i < numSamples; ++i) {
+			//  HSchlickGGXҪԲ
+			const float u = float(i) / float(numSamples);
+			const float v = radicalInverse(uint32_t(i));
+			const float cosTheta = std::sqrt((1.0f - v) / (1.0f + (alpha * alpha - 1.0f) * v));
+			const float sinTheta = std::sqrt(1.0f - cosTheta * cosTheta);
+			const float8 Hx(sinTheta * std::cos(2.0f * PI * u));
+			const float8 Hz(cosTheta);
+
+			// ䷽ L = 2 * dot(V, H) * H - VֻҪz
+			const float8 VdotHRaw = simd::fmadd(Vx, Hx, NdotV * Hz);
+			const float8 NdotL = float8(2.0f) * VdotHRaw * Hz - NdotV;
+			const float8 VdotH = simd::max(VdotHRaw, zero);
+
+			const float8 G = gaSchlickG1(simd::max(NdotL, zero), k) * GV;
+			const float8 Gv = G * VdotH / (Hz * NdotV);
+			const float8 f = one - VdotH;
+			const float8 f2 = f * f;
+			const float8 Fc = f2 * f2 * f;
+
+			const float8 valid = NdotL > zero;
+			scale = scale + simd::select(valid, (one - Fc) * Gv, zero);
+			bias = bias + simd::select(valid, Fc * Gv, zero);
+		}
+
+		const float8 invNumSamples(1.0f / float(numSamples));
+		(scale * invNumSamples).store(scaleOut);
+		(bias * invNumSamples).store(biasOut);
+	}
+}
+
+std::vector<uint16_t> BRDFLUT::integrate(int size, int numSamples)
+{
+	std::vector<uint16_t> pixels(size_t(size) * size * 2);
+
+	ThreadPool::global().parallelFor(0, size, [&](int y) {
+		// ͼxΪNdotVyΪroughnessȡ˫Բ
+		const float roughness = (float(y) + 0.5f) / float(size);
+
+		std::vector<float> row(size_t(size) * 2);
+		float scale[simd::Width];
+		float bias[simd::Width];
+		for (int x = 0; x < size; x += simd::Width) {
+			integrateTexels8(float(x), roughness, size, numSamples, scale, bias);
+			for (int lane = 0; lane < simd::Width && x + lane < size; ++lane) {
+				row[2 * (x + lane) + 0] = scale[lane];
+				row[2 * (x + lane) + 1] = bias[lane];
+			}
+		}
+		simd::floatToHalf(row.data(), &pixels[size_t(y) * size * 2], row.size());
+	});
+	return pixels;
+}
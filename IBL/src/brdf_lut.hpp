@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// split-sumеBRDFֱ (NdotV, roughness) -> (scale, bias)F0 * scale + bias Ϊ淴ĻBRDF
+// 뻷ͼ޹أLUTGenɺRG16Fʱֱϴ
+class BRDFLUT
+{
+public:
+	// ǶĳߴͻֲLUT仯ƽ128x128˫Թ㹻
+	static const int Size = 128;
+	static const int NumSamples = 1024;
+
+	// CPU֣ size*size RG half floatyжӦ roughness = (y + 0.5) / size
+	static std::vector<uint16_t> integrate(int size, int numSamples);
+
+	// ԤߴΪSizeʽintegrate()ͬ
+	static const uint16_t* embedded();
+};
@@ -0,0 +1,14 @@
+#include "brdf_lut.hpp"
+
+namespace
+{
+	// LUTGenɣ޸BRDFLUT::SizeNumSamplesҪLUTGen
+	const uint16_t EmbeddedLUT[BRDFLUT::Size * BRDFLUT::Size * 2] = {
+#include "brdf_lut.inc"
+	};
+}
+
+const uint16_t* BRDFLUT::embedded()
+{
+	return EmbeddedLUT;
+}
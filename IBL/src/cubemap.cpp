@@ -0,0 +1,67 @@
+#include <stdexcept>
+
+#include "cubemap.hpp"
+#include "utils.hpp"
+#include "thread_pool.hpp"
+
+CubeMap::CubeMap(int size, int levels)
+	: m_size(size)
+	, m_levels(levels > 0 ? levels : Utility::numMipmapLevels(size, size))
+{
+	if (size <= 0 || !Utility::isPowerOfTwo(size)) {
+		throw std::runtime_error("Cube map size must be a power of two: " + std::to_string(size));
+	}
+
+	size_t total = 0;
+	m_offsets.resize(m_levels);
+	for (int level = 0; level < m_levels; ++level) {
+		m_offsets[level] = total;
+		total += levelSize(level);
+	}
+	m_pixels.resize(total, 0.0f);
+}
+
+glm::vec3 CubeMap::texelDirection(int face, float s, float t)
+{
+	const glm::vec2 uv = 2.0f * glm::vec2(s, 1.0f - t) - glm::vec2(1.0f);
+
+	glm::vec3 ret;
+	switch (face) {
+	case 0: ret = glm::vec3(1.0f, uv.y, -uv.x); break;
+	case 1: ret = glm::vec3(-1.0f, uv.y, uv.x); break;
+	case 2: ret = glm::vec3(uv.x, 1.0f, -uv.y); break;
+	case 3: ret = glm::vec3(uv.x, -1.0f, uv.y); break;
+	case 4: ret = glm::vec3(uv.x, uv.y, 1.0f); break;
+	default: ret = glm::vec3(-uv.x, uv.y, -1.0f); break;
+	}
+	return glm::normalize(ret);
+}
+
+void CubeMap::generateMipmaps(int firstLevel)
+{
+	for (int level = firstLevel; level < m_levels; ++level) {
+		const int dstSize = size(level);
+		ThreadPool::global().parallelFor(0, NumFaces * dstSize, [&](int row) {
+			downsample(level, row / dstSize, 0, row % dstSize, dstSize, 1);
+		});
+	}
+}
+
+void CubeMap::downsample(int level, int face, int x0, int y0, int width, int height)
+{
+	const int dstSize = size(level);
+	const int srcSize = size(level - 1);
+	const float* src = this->face(level - 1, face);
+	for (int y = y0; y < y0 + height; ++y) {
+		float* dst = this->face(level, face) + size_t(y) * dstSize * NumChannels;
+		const float* src0 = src + size_t(2 * y) * srcSize * NumChannels;
+		const float* src1 = src0 + size_t(srcSize) * NumChannels;
+		for (int x = x0; x < x0 + width; ++x) {
+			for (int c = 0; c < NumChannels; ++c) {
+				dst[x * NumChannels + c] = 0.25f * (
+					src0[(2 * x) * NumChannels + c] + src0[(2 * x + 1) * NumChannels + c] +
+					src1[(2 * x) * NumChannels + c] + src1[(2 * x + 1) * NumChannels + c]);
+			}
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+
+// CPU˵cube mapOpenGLģ/޴ں決
+// ÿmipmap水 +X,-X,+Y,-Y,+Z,-Z ţΪRGBA float
+class CubeMap
+{
+public:
+	static const int NumFaces = 6;
+	static const int NumChannels = 4;
+
+	// levelsΪ0ʱmipmap
+	CubeMap(int size, int levels = 0);
+
+	int size(int level = 0) const { return glm::max(m_size >> level, 1); }
+	int levels() const { return m_levels; }
+
+	// ĳmipmapռõfloat
+	size_t levelSize(int level) const { return size_t(NumFaces) * size(level) * size(level) * NumChannels; }
+
+	float* level(int level) { return &m_pixels[m_offsets[level]]; }
+	const float* level(int level) const { return &m_pixels[m_offsets[level]]; }
+	float* face(int level, int face) { return this->level(level) + levelSize(level) / NumFaces * face; }
+	const float* face(int level, int face) const { return this->level(level) + levelSize(level) / NumFaces * face; }
+
+	// ɫgetSamplingVector()һ£(s, t)[0,1]t=0Ϊһ
+	static glm::vec3 texelDirection(int face, float s, float t);
+
+	// 2x2ʽ˲ɵfirstLevel-1֮ĸ
+	void generateMipmaps(int firstLevel = 1);
+	// 2x2ʽ˲ɵlevel-1levelĳϵһ
+	void downsample(int level, int face, int x0, int y0, int width, int height);
+
+private:
+	int m_size;
+	int m_levels;
+	std::vector<size_t> m_offsets;
+	std::vector<float> m_pixels;
+};
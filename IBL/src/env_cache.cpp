@@ -0,0 +1,166 @@
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "env_cache.hpp"
+#include "image.hpp"
+#include "simd.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	const uint32_t CacheVersion = 2;
+
+	struct EnvironmentHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		int32_t envMapSize;
+		int32_t prefilterSamples;
+		int32_t shProjectionSize;
+		int32_t levels;
+		glm::vec4 irradianceSH[IBLBaker::NumSHCoefficients];
+	};
+}
+
+const char* EnvironmentCache::Directory = "./data/cache";
+
+std::shared_ptr<BakedEnvironment> BakedEnvironment::fromCubeMap(const CubeMap& prefiltered, const IBLBaker::SHCoefficients& irradianceSH)
+{
+	std::shared_ptr<BakedEnvironment> environment = std::make_shared<BakedEnvironment>();
+	environment->size = prefiltered.size();
+	environment->levels = prefiltered.levels();
+	environment->irradianceSH = irradianceSH;
+	environment->levelPixels.resize(prefiltered.levels());
+	for (int level = 0; level < prefiltered.levels(); ++level) {
+		environment->levelPixels[level].resize(prefiltered.levelSize(level));
+		simd::floatToHalf(prefiltered.level(level), environment->levelPixels[level].data(), prefiltered.levelSize(level));
+	}
+	return environment;
+}
+
+std::vector<std::vector<uint8_t>> BakedEnvironment::compress(BlockCompressor::Quality quality) const
+{
+	std::vector<std::vector<uint8_t>> compressed(levels);
+	for (int level = 0; level < levels; ++level) {
+		const int levelSize = glm::max(size >> level, 1);
+		const size_t facePixels = size_t(levelSize) * levelSize * CubeMap::NumChannels;
+		// ÿ浥ѹС4x4Ĳ㼶鲻ܿ
+		std::shared_ptr<Image> face = Image::create(levelSize, levelSize, CubeMap::NumChannels, Image::Format::Float16);
+		for (int f = 0; f < CubeMap::NumFaces; ++f) {
+			std::memcpy(face->pixels<uint16_t>(), levelPixels[level].data() + facePixels * f, facePixels * sizeof(uint16_t));
+			const std::vector<uint8_t> blocks = BlockCompressor::compressLevel(*face, CompressedTexture::Format::BC6H, nullptr, quality);
+			compressed[level].insert(compressed[level].end(), blocks.begin(), blocks.end());
+		}
+	}
+	return compressed;
+}
+
+size_t BakedEnvironment::compressedFaceBytes(int level) const
+{
+	const int levelSize = glm::max(size >> level, 1);
+	return BlockCompressor::levelBytes(CompressedTexture::Format::BC6H, levelSize, levelSize);
+}
+
+std::string EnvironmentCache::Key::fileName() const
+{
+	uint64_t hash = Utility::hashValue(sourceHash, CacheVersion);
+	hash = Utility::hashValue(envMapSize, hash);
+	hash = Utility::hashValue(prefilterSamples, hash);
+	hash = Utility::hashValue(shProjectionSize, hash);
+
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016" PRIx64 ".ibl", hash);
+	return std::string(Directory) + "/" + name;
+}
+
+EnvironmentCache::Key EnvironmentCache::makeKey(const std::string& hdrFilename, int envMapSize)
+{
+	const std::shared_ptr<MappedFile> file = MappedFile::open(hdrFilename);
+	return makeKey(file->data(), file->size(), envMapSize);
+}
+
+EnvironmentCache::Key EnvironmentCache::makeKey(const void* hdrContent, size_t size, int envMapSize)
+{
+	Key key;
+	key.sourceHash = Utility::hash64(hdrContent, size);
+	key.envMapSize = envMapSize;
+	key.prefilterSamples = IBLBaker::PrefilterSamples;
+	key.shProjectionSize = IBLBaker::SHProjectionSize;
+	return key;
+}
+
+std::shared_ptr<BakedEnvironment> EnvironmentCache::load(const Key& key)
+{
+	const std::string filename = key.fileName();
+	if (!File::exists(filename)) {
+		return nullptr;
+	}
+
+	// ӳֱӿУļм仺
+	const std::shared_ptr<MappedFile> file = MappedFile::open(filename);
+	const char* content = file->data();
+	if (file->size() < sizeof(EnvironmentHeader)) {
+		return nullptr;
+	}
+
+	EnvironmentHeader header;
+	std::memcpy(&header, content, sizeof(header));
+	if (std::memcmp(header.magic, "IBLE", 4) != 0 || header.version != CacheVersion ||
+		header.sourceHash != key.sourceHash || header.envMapSize != key.envMapSize ||
+		header.prefilterSamples != key.prefilterSamples || header.shProjectionSize != key.shProjectionSize) {
+		return nullptr;
+	}
+	// ļcube mapmipmapʱ𻵵Ļ
+	if (header.envMapSize <= 0 || header.levels <= 0 || header.levels > Utility::numMipmapLevels(header.envMapSize, header.envMapSize)) {
+		std::cout << "Corrupted IBL cache file: " << filename << std::endl;
+		return nullptr;
+	}
+
+	std::shared_ptr<BakedEnvironment> environment = std::make_shared<BakedEnvironment>();
+	environment->size = header.envMapSize;
+	environment->levels = header.levels;
+	std::memcpy(environment->irradianceSH.data(), header.irradianceSH, sizeof(header.irradianceSH));
+	environment->compressedLevels.resize(header.levels);
+
+	size_t offset = sizeof(EnvironmentHeader);
+	for (int level = 0; level < header.levels; ++level) {
+		const size_t bytes = environment->compressedFaceBytes(level) * CubeMap::NumFaces;
+		if (offset + bytes > file->size()) {
+			std::cout << "Truncated IBL cache file: " << filename << std::endl;
+			return nullptr;
+		}
+		environment->compressedLevels[level].assign(content + offset, content + offset + bytes);
+		offset += bytes;
+	}
+
+	std::cout << "Loaded IBL cache: " << filename << std::endl;
+	return environment;
+}
+
+void EnvironmentCache::store(const Key& key, const BakedEnvironment& environment, BlockCompressor::Quality quality)
+{
+	const std::vector<std::vector<uint8_t>> compressedLevels = environment.isCompressed() ? environment.compressedLevels : environment.compress(quality);
+
+	EnvironmentHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "IBLE", 4);
+	header.version = CacheVersion;
+	header.sourceHash = key.sourceHash;
+	header.envMapSize = key.envMapSize;
+	header.prefilterSamples = key.prefilterSamples;
+	header.shProjectionSize = key.shProjectionSize;
+	header.levels = environment.levels;
+	std::memcpy(header.irradianceSH, environment.irradianceSH.data(), sizeof(header.irradianceSH));
+
+	std::vector<char> content(reinterpret_cast<const char*>(&header), reinterpret_cast<const char*>(&header) + sizeof(header));
+	for (const std::vector<uint8_t>& blocks : compressedLevels) {
+		content.insert(content.end(), blocks.begin(), blocks.end());
+	}
+
+	File::createDirectory(Directory);
+	File::writeBinary(key.fileName(), content.data(), content.size());
+	std::cout << "Stored IBL cache: " << key.fileName() << std::endl;
+}
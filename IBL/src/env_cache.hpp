@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "baker.hpp"
+#include "block_compressor.hpp"
+
+// 決õĻգԤ˲mipmapԼõгϵ
+struct BakedEnvironment
+{
+	int size;
+	int levels;
+	// ÿmipmapţΪRGBA half floatֱglTextureSubImage3Dϴ
+	std::vector<std::vector<uint16_t>> levelPixels;
+	// BC6HѹmipmapÿĿţӻȡʱֻһlevelPixelsΪ
+	std::vector<std::vector<uint8_t>> compressedLevels;
+	IBLBaker::SHCoefficients irradianceSH;
+
+	bool isCompressed() const { return !compressedLevels.empty(); }
+	// levelPixelsѹBC6HmipmapΪRGBA16F1/8
+	std::vector<std::vector<uint8_t>> compress(BlockCompressor::Quality quality) const;
+	// һmipmapһBC6HݴС
+	size_t compressedFaceBytes(int level) const;
+
+	static std::shared_ptr<BakedEnvironment> fromCubeMap(const CubeMap& prefiltered, const IBLBaker::SHCoefficients& irradianceSH);
+};
+
+// ϵIBL決棬ΪHDRļݵĹϣϺ決
+// Ԥ˲BC6H洢ʱֱϴѹݣеļɫ
+class EnvironmentCache
+{
+public:
+	struct Key
+	{
+		uint64_t sourceHash;
+		int32_t envMapSize;
+		int32_t prefilterSamples;
+		int32_t shProjectionSize;
+
+		std::string fileName() const;
+	};
+
+	static Key makeKey(const std::string& hdrFilename, int envMapSize);
+	// hdrContentΪHDRļݣͨڴӳ䣩֮ͬһӳ룬ظļ
+	static Key makeKey(const void* hdrContent, size_t size, int envMapSize);
+
+	// ûл򻺴ʱnullptr
+	static std::shared_ptr<BakedEnvironment> load(const Key& key);
+	// environmentûѹʱqualityѹд
+	static void store(const Key& key, const BakedEnvironment& environment, BlockCompressor::Quality quality = BlockCompressor::Quality::Normal);
+
+private:
+	static const char* Directory;
+};
@@ -0,0 +1,237 @@
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "hdr_reader.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	// halfܱʾֵؽضϵԤ˲ʱinf
+	const float MaxHalf = 65504.0f;
+	// ÿɨ
+	const int ScanlinesPerBlock = 32;
+
+	struct Header
+	{
+		int width;
+		int height;
+		size_t dataOffset;
+	};
+
+	Header parseHeader(const char* content, size_t size)
+	{
+		size_t pos = 0;
+		auto readLine = [&]() {
+			const size_t begin = pos;
+			while (pos < size && content[pos] != '\n') {
+				++pos;
+			}
+			if (pos >= size) {
+				throw std::runtime_error("Unexpected end of Radiance header");
+			}
+			return std::string(content + begin, content + pos++);
+		};
+
+		const std::string magic = readLine();
+		if (magic.compare(0, 2, "#?") != 0) {
+			throw std::runtime_error("Not a Radiance HDR file");
+		}
+		// ͷĸԿн
+		for (std::string line = readLine(); !line.empty(); line = readLine()) {
+			if (line.compare(0, 7, "FORMAT=") == 0 && line != "FORMAT=32-bit_rle_rgbe") {
+				throw std::runtime_error("Unsupported Radiance pixel format: " + line.substr(7));
+			}
+		}
+
+		// ֱֻ֧׼Ĵϵ¡ҵɨ˳
+		Header header;
+		const std::string resolution = readLine();
+		if (std::sscanf(resolution.c_str(), "-Y %d +X %d", &header.height, &header.width) != 2 || header.width <= 0 || header.height <= 0) {
+			throw std::runtime_error("Unsupported Radiance resolution: " + resolution);
+		}
+		header.dataOffset = pos;
+		return header;
+	}
+
+	// ʽRLEɨ 2, 2, ȸλ, ȵλ ͷ֮RGBEĸֱͨγ̱
+	bool isRLE(const unsigned char* data, size_t size, int width)
+	{
+		return width >= 8 && width < 32768 && size >= 4 && data[0] == 2 && data[1] == 2 && (data[2] & 0x80) == 0;
+	}
+
+	// һRLEɨߣһ
+	size_t skipScanline(const unsigned char* data, size_t size, size_t pos, int width)
+	{
+		if (pos + 4 > size || data[pos] != 2 || data[pos + 1] != 2 || ((data[pos + 2] << 8) | data[pos + 3]) != width) {
+			throw std::runtime_error("Invalid Radiance scanline");
+		}
+		pos += 4;
+		for (int channel = 0; channel < 4; ++channel) {
+			for (int x = 0; x < width;) {
+				if (pos >= size) {
+					throw std::runtime_error("Unexpected end of Radiance data");
+				}
+				int count = data[pos++];
+				if (count > 128) {
+					count -= 128;
+					pos += 1;
+				}
+				else {
+					pos += count;
+				}
+				if (count == 0 || x + count > width) {
+					throw std::runtime_error("Invalid Radiance run length");
+				}
+				x += count;
+			}
+		}
+		if (pos > size) {
+			throw std::runtime_error("Unexpected end of Radiance data");
+		}
+		return pos;
+	}
+
+	// һRLEɨߵĸƽ棨RGBEλѾskipScanlineУ
+	void decodeScanline(const unsigned char* data, size_t pos, int width, unsigned char* planes[4])
+	{
+		pos += 4;
+		for (int channel = 0; channel < 4; ++channel) {
+			unsigned char* dst = planes[channel];
+			for (int x = 0; x < width;) {
+				int count = data[pos++];
+				if (count > 128) {
+					count -= 128;
+					std::memset(dst + x, data[pos++], count);
+				}
+				else {
+					std::memcpy(dst + x, data + pos, count);
+					pos += count;
+				}
+				x += count;
+			}
+		}
+	}
+
+	// RGBE -> RGB halfvalue = byte * 2^(E - 136)EΪ0ʱǺɫ
+	// planesĳҪϲ뵽simd::Width
+	// 8صRGBEתΪfloat
+	void unpackRGBE8(unsigned char* const planes[4], int x, simd::float8 rgb[3])
+	{
+		using namespace simd;
+
+		// 2^(E - 136) ĸʾ (E - 9) << 23E <= 9 ʱhalfRGB9E5ľȣֱȡ0
+		const int8 e = int8::loadBytes(planes[3] + x);
+		const float8 scale = select(toFloat(e) > float8(9.0f), asFloat((e - int8(9)) * int8(1 << 23)), float8(0.0f));
+		for (int c = 0; c < 3; ++c) {
+			rgb[c] = toFloat(int8::loadBytes(planes[c] + x)) * scale;
+		}
+	}
+
+	void convertScanline(unsigned char* const planes[4], int width, uint16_t* dst)
+	{
+		using namespace simd;
+
+		uint16_t rgb[3][Width];
+		for (int x = 0; x < width; x += Width) {
+			float8 value[3];
+			unpackRGBE8(planes, x, value);
+			for (int c = 0; c < 3; ++c) {
+				storeHalf(min(value[c], float8(MaxHalf)), rgb[c]);
+			}
+
+			const int count = std::min(Width, width - x);
+			for (int lane = 0; lane < count; ++lane) {
+				dst[3 * (x + lane) + 0] = rgb[0][lane];
+				dst[3 * (x + lane) + 1] = rgb[1][lane];
+				dst[3 * (x + lane) + 2] = rgb[2][lane];
+			}
+		}
+	}
+
+	// RGBE8λβRGB9E5ķΧڿʾ
+	void convertScanline(unsigned char* const planes[4], int width, uint32_t* dst)
+	{
+		using namespace simd;
+
+		int32_t packed[Width];
+		for (int x = 0; x < width; x += Width) {
+			float8 value[3];
+			unpackRGBE8(planes, x, value);
+			packRGB9E5(value[0], value[1], value[2]).store(packed);
+			std::memcpy(dst + x, packed, std::min(Width, width - x) * sizeof(uint32_t));
+		}
+	}
+}
+
+std::shared_ptr<Image> HDRReader::fromFile(const std::string& filename, Image::Format format)
+{
+	std::printf("Loading image: %s\n", filename.c_str());
+	const std::shared_ptr<MappedFile> file = MappedFile::open(filename);
+	return decode(file->data(), file->size(), format);
+}
+
+std::shared_ptr<Image> HDRReader::decode(const void* content, size_t size, Image::Format format)
+{
+	if (format != Image::Format::Float16 && format != Image::Format::RGB9E5) {
+		throw std::runtime_error("Radiance images can only be decoded to half or RGB9E5");
+	}
+
+	const Header header = parseHeader(static_cast<const char*>(content), size);
+	const int width = header.width;
+	const int height = header.height;
+	const unsigned char* data = static_cast<const unsigned char*>(content);
+
+	// stb_imageһ£һɨ߲RLEʱͼδѹRGBEȡ
+	const bool rle = isRLE(data + header.dataOffset, size - header.dataOffset, width);
+	std::vector<size_t> offsets(height);
+	if (rle) {
+		// ɨߵĳҪγ̲֪һֻܴУдκ
+		size_t pos = header.dataOffset;
+		for (int y = 0; y < height; ++y) {
+			offsets[y] = pos;
+			pos = skipScanline(data, size, pos, width);
+		}
+	}
+	else {
+		if (header.dataOffset + size_t(width) * height * 4 > size) {
+			throw std::runtime_error("Unexpected end of Radiance data");
+		}
+		for (int y = 0; y < height; ++y) {
+			offsets[y] = header.dataOffset + size_t(width) * 4 * y;
+		}
+	}
+
+	std::shared_ptr<Image> image = Image::create(width, height, 3, format);
+
+	const int numBlocks = (height + ScanlinesPerBlock - 1) / ScanlinesPerBlock;
+	const int paddedWidth = Utility::roundToPowerOfTwo(width, simd::Width);
+	ThreadPool::global().parallelFor(0, numBlocks, [&](int block) {
+		std::vector<unsigned char> buffer(size_t(paddedWidth) * 4, 0);
+		unsigned char* planes[4] = { &buffer[0], &buffer[paddedWidth], &buffer[2 * paddedWidth], &buffer[3 * paddedWidth] };
+
+		const int endY = std::min(height, (block + 1) * ScanlinesPerBlock);
+		for (int y = block * ScanlinesPerBlock; y < endY; ++y) {
+			if (rle) {
+				decodeScanline(data, offsets[y], width, planes);
+			}
+			else {
+				const unsigned char* src = data + offsets[y];
+				for (int x = 0; x < width; ++x) {
+					for (int c = 0; c < 4; ++c) {
+						planes[c][x] = src[4 * x + c];
+					}
+				}
+			}
+			if (format == Image::Format::RGB9E5) {
+				convertScanline(planes, width, image->pixels<uint32_t>() + size_t(y) * width);
+			}
+			else {
+				convertScanline(planes, width, image->pixels<uint16_t>() + size_t(y) * width * 3);
+			}
+		}
+	});
+	return image;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "image.hpp"
+
+// Radiance .hdrRGBEȡֱӽΪRGB half floatRGB9E5float RGB
+// ȴɨһҵÿɨߵ㣬ٰ鲢RLESIMDת
+class HDRReader
+{
+public:
+	static std::shared_ptr<Image> fromFile(const std::string& filename, Image::Format format = Image::Format::Float16);
+	// contentΪ.hdrļݣͨļڴӳ䣩formatֻFloat16RGB9E5
+	static std::shared_ptr<Image> decode(const void* content, size_t size, Image::Format format = Image::Format::Float16);
+};
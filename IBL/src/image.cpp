@@ -1,35 +1,68 @@
+#include <algorithm>
+#include <climits>
+#include <cstring>
 #include <stdexcept>
 #include <stb/stb_image.h>
 #include <iostream>
+#include <vector>
 
 #include "image.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
 
 
 Image::Image()
 	: m_width(0)
 	, m_height(0)
 	, m_channels(0)
-	, m_hdr(false)
+	, m_format(Format::UNorm8)
+	, m_pixels(nullptr, std::free)
 {}
 
 std::shared_ptr<Image> Image::fromFile(const std::string& filename, int channels)
 {
 	std::printf("Loading image: %s\n", filename.c_str());
 
+	const std::shared_ptr<MappedFile> file = MappedFile::open(filename);
+	std::shared_ptr<Image> image = decode(file->data(), file->size(), channels);
+	if (!image) {
+		throw std::runtime_error("Failed to load image file: " + filename);
+	}
+	return image;
+}
+
+std::shared_ptr<Image> Image::fromMemory(const void* data, size_t size, int channels)
+{
+	std::shared_ptr<Image> image = decode(data, size, channels);
+	if (!image) {
+		throw std::runtime_error(std::string("Failed to decode image: ") + stbi_failure_reason());
+	}
+	return image;
+}
+
+std::shared_ptr<Image> Image::decode(const void* data, size_t size, int channels)
+{
 	std::shared_ptr<Image> image{ new Image };
 
-	if (stbi_is_hdr(filename.c_str())) {
-		float* pixels = stbi_loadf(filename.c_str(), &image->m_width, &image->m_height, &image->m_channels, channels);
+	// stbֻһڴеݣļͷжϺͽ벻ٸԴļȲint2GBļ޷
+	if (size > size_t(INT_MAX)) {
+		throw std::runtime_error("Image data is too large to decode");
+	}
+	const stbi_uc* bytes = static_cast<const stbi_uc*>(data);
+	const int length = int(size);
+	if (stbi_is_hdr_from_memory(bytes, length)) {
+		float* pixels = stbi_loadf_from_memory(bytes, length, &image->m_width, &image->m_height, &image->m_channels, channels);
 		if (pixels) {
 			image->m_pixels.reset(reinterpret_cast<unsigned char*>(pixels));
-			image->m_hdr = true;
+			image->m_format = Format::Float32;
 		}
 	}
 	else {
-		unsigned char* pixels = stbi_load(filename.c_str(), &image->m_width, &image->m_height, &image->m_channels, channels);
+		unsigned char* pixels = stbi_load_from_memory(bytes, length, &image->m_width, &image->m_height, &image->m_channels, channels);
 		if (pixels) {
 			image->m_pixels.reset(pixels);
-			image->m_hdr = false;
+			image->m_format = Format::UNorm8;
 		}
 	}
 	if (channels > 0) {
@@ -37,7 +70,131 @@ std::shared_ptr<Image> Image::fromFile(const std::string& filename, int channels
 	}
 
 	if (!image->m_pixels) {
-		throw std::runtime_error("Failed to load image file: " + filename);
+		return nullptr;
 	}
 	return image;
 }
+
+std::shared_ptr<Image> Image::create(int width, int height, int channels, Format format)
+{
+	std::shared_ptr<Image> image{ new Image };
+	image->m_width = width;
+	image->m_height = height;
+	image->m_channels = channels;
+	image->m_format = format;
+	if (format == Format::RGB9E5) {
+		image->m_channels = 3;
+	}
+	image->m_pixels.reset(static_cast<unsigned char*>(std::malloc(size_t(image->pitch()) * height)));
+	if (!image->m_pixels) {
+		throw std::runtime_error("Failed to allocate image");
+	}
+	return image;
+}
+
+std::shared_ptr<Image> Image::packChannels(const std::vector<std::shared_ptr<Image>>& sources, const std::vector<unsigned char>& defaults)
+{
+	int width = 1, height = 1;
+	for (const std::shared_ptr<Image>& source : sources) {
+		if (source) {
+			if (source->m_format != Format::UNorm8 || source->m_channels != 1) {
+				throw std::runtime_error("Only single-channel 8-bit images can be packed");
+			}
+			width = std::max(width, source->m_width);
+			height = std::max(height, source->m_height);
+		}
+	}
+
+	const int channels = int(sources.size());
+	std::shared_ptr<Image> result = create(width, height, channels, Format::UNorm8);
+	ThreadPool::global().parallelFor(0, height, [&](int y) {
+		unsigned char* dst = result->m_pixels.get() + size_t(y) * result->pitch();
+		for (int c = 0; c < channels; ++c) {
+			const Image* source = sources[c].get();
+			if (!source) {
+				for (int x = 0; x < width; ++x) {
+					dst[x * channels + c] = defaults[c];
+				}
+				continue;
+			}
+			const unsigned char* src = source->m_pixels.get() + size_t(y * source->m_height / height) * source->m_width;
+			for (int x = 0; x < width; ++x) {
+				dst[x * channels + c] = src[x * source->m_width / width];
+			}
+		}
+	});
+	return result;
+}
+
+int Image::bytesPerPixel() const
+{
+	switch (m_format) {
+	case Format::Float32:
+		return m_channels * 4;
+	case Format::Float16:
+		return m_channels * 2;
+	case Format::RGB9E5:
+		return 4;
+	default:
+		return m_channels;
+	}
+}
+
+std::shared_ptr<Image> Image::convert(Format format) const
+{
+	if (!isHDR() || format == Format::UNorm8) {
+		throw std::runtime_error("Image conversion is only supported between HDR formats");
+	}
+	if (format == Format::RGB9E5 && m_channels < 3) {
+		throw std::runtime_error("RGB9E5 requires an RGB image");
+	}
+
+	std::shared_ptr<Image> result = create(m_width, m_height, m_channels, format);
+	const int channels = result->m_channels;
+	const size_t srcPitch = pitch();
+	const size_t dstPitch = result->pitch();
+	const unsigned char* src = m_pixels.get();
+	unsigned char* dst = result->m_pixels.get();
+
+	// halffloatֱ֮תһfloatת
+	ThreadPool::global().parallelFor(0, m_height, [&](int y) {
+		const unsigned char* srcRow = src + y * srcPitch;
+		unsigned char* dstRow = dst + y * dstPitch;
+		const size_t count = size_t(m_width) * channels;
+
+		if (m_format == format) {
+			std::memcpy(dstRow, srcRow, dstPitch);
+		}
+		else if (m_format == Format::Float32 && format == Format::Float16) {
+			simd::floatToHalf(reinterpret_cast<const float*>(srcRow), reinterpret_cast<uint16_t*>(dstRow), count);
+		}
+		else if (m_format == Format::Float16 && format == Format::Float32) {
+			simd::halfToFloat(reinterpret_cast<const uint16_t*>(srcRow), reinterpret_cast<float*>(dstRow), count);
+		}
+		else {
+			std::vector<float> row;
+			const float* floats = reinterpret_cast<const float*>(srcRow);
+			if (m_format != Format::Float32) {
+				row.resize(size_t(m_width) * m_channels);
+				if (m_format == Format::Float16) {
+					simd::halfToFloat(reinterpret_cast<const uint16_t*>(srcRow), row.data(), row.size());
+				}
+				else {
+					simd::rgb9e5ToFloat(reinterpret_cast<const uint32_t*>(srcRow), row.data(), 3, m_width);
+				}
+				floats = row.data();
+			}
+
+			if (format == Format::RGB9E5) {
+				simd::floatToRGB9E5(floats, m_channels, reinterpret_cast<uint32_t*>(dstRow), m_width);
+			}
+			else if (format == Format::Float16) {
+				simd::floatToHalf(floats, reinterpret_cast<uint16_t*>(dstRow), count);
+			}
+			else {
+				std::memcpy(dstRow, floats, dstPitch);
+			}
+		}
+	});
+	return result;
+}
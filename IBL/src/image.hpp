@@ -1,34 +1,66 @@
 #pragma once
 
 #include <cassert>
+#include <cstdlib>
 #include <memory>
 #include <string>
+#include <vector>
 
 class Image
 {
 public:
+	// ظʽ8λ޷Źһ32λfloat16λhalf float
+	// ָRGB9E5ÿһuint32̶3ͨ
+	enum class Format
+	{
+		UNorm8,
+		Float32,
+		Float16,
+		RGB9E5,
+	};
+
 	static std::shared_ptr<Image> fromFile(const std::string& filename, int channels = 4);
+	// ڴеͼļļڴӳ䣩
+	static std::shared_ptr<Image> fromMemory(const void* data, size_t size, int channels = 4);
+	// һδʼͼɵ
+	static std::shared_ptr<Image> create(int width, int height, int channels, Format format);
 
 	int width() const { return m_width; }
 	int height() const { return m_height; }
 	int channels() const { return m_channels; }
-	int bytesPerPixel() const { return m_channels * (m_hdr ? sizeof(float) : sizeof(unsigned char)); }
+	Format format() const { return m_format; }
+	int bytesPerPixel() const;
 	int pitch() const { return m_width * bytesPerPixel(); }
 
-	bool isHDR() const { return m_hdr; }
+	bool isHDR() const { return m_format != Format::UNorm8; }
+
+	// ɵͨ8λͼϲΪһŶͨͼsources[i]Ϊʱiͨdefaults[i]
+	// ߴȡԴͼ񣬳ߴ粻ͬԴڲ
+	static std::shared_ptr<Image> packChannels(const std::vector<std::shared_ptr<Image>>& sources, const std::vector<unsigned char>& defaults);
+
+	// HDRʽ֮תвУתΪRGB9E5ʱalpha
+	std::shared_ptr<Image> convert(Format format) const;
 
 	template<typename T>
 	const T* pixels() const
 	{
 		return reinterpret_cast<const T*>(m_pixels.get());
 	}
+	template<typename T>
+	T* pixels()
+	{
+		return reinterpret_cast<T*>(m_pixels.get());
+	}
 
 private:
 	Image();
+	// ʧʱnullptr
+	static std::shared_ptr<Image> decode(const void* data, size_t size, int channels);
 
 	int m_width;
 	int m_height;
 	int m_channels;
-	bool m_hdr;
-	std::unique_ptr<unsigned char> m_pixels;
-};
\ No newline at end of file
+	Format m_format;
+	// stb_imagemallocأͳһfreeͷ
+	std::unique_ptr<unsigned char, void(*)(void*)> m_pixels;
+};
@@ -1,15 +1,35 @@
 #include <cstdio>
+#include <cstring>
+#include <chrono>
 #include <string>
 #include <memory>
 
 #include "application.hpp"
 #include "opengl.hpp"
 #include "math.hpp"
+#include "image.hpp"
+#include "hdr_reader.hpp"
+#include "baker.hpp"
+#include "env_cache.hpp"
+
+const int BakeEnvMapSize = 1024;
 
 void init();
+int bakeEnvironments(int argc, char* argv[]);
 
 int main(int argc, char* argv[])
 {
+	// ޴ģʽIBL.exe --bake [--quality=fast|normal|high] [ͼ...]ֻCPUϺ決OpenGL
+	if (argc > 1 && std::strcmp(argv[1], "--bake") == 0) {
+		try {
+			return bakeEnvironments(argc - 2, argv + 2);
+		}
+		catch (const std::exception& e) {
+			std::fprintf(stderr, "Error: %s\n", e.what());
+			return 1;
+		}
+	}
+
 	init();
 	Renderer* renderer = new Renderer();
 	try {
@@ -44,6 +64,10 @@ void init()
 	Application::sceneSetting.objectScale = 25.0;
 	Application::sceneSetting.objectPitch = 0;
 	Application::sceneSetting.objectYaw = -90;
+	Application::sceneSetting.envBakeBudget = 4.0f;
+	Application::sceneSetting.packedVertices = true;
+	Application::sceneSetting.gpuCacheBudget = 1024.0f;
+	Application::sceneSetting.cpuCacheBudget = 1024.0f;
 
 	// 
 	Application::sceneSetting.lights[0].direction = toVec3f(glm::normalize(glm::vec3{ -1.0f,  0.0f, 0.0f }));
@@ -54,3 +78,54 @@ void init()
 	Application::sceneSetting.lights[1].radiance = std::vector<float>(3, 1.0f);
 	Application::sceneSetting.lights[2].radiance = std::vector<float>(3, 1.0f);
 }
+
+int bakeEnvironments(int argc, char* argv[])
+{
+	// BC6Hѹλ
+	BlockCompressor::Quality quality = BlockCompressor::Quality::Normal;
+	std::vector<std::string> envNames;
+	for (int i = 0; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--quality=fast") == 0) {
+			quality = BlockCompressor::Quality::Fast;
+		}
+		else if (std::strcmp(argv[i], "--quality=normal") == 0) {
+			quality = BlockCompressor::Quality::Normal;
+		}
+		else if (std::strcmp(argv[i], "--quality=high") == 0) {
+			quality = BlockCompressor::Quality::High;
+		}
+		else {
+			envNames.push_back(argv[i]);
+		}
+	}
+	if (envNames.empty()) {
+		for (char* name : File::readAllFilesInDir(".\\data\\hdr")) {
+			envNames.push_back(name);
+		}
+	}
+
+	for (const std::string& envName : envNames) {
+		const auto start = std::chrono::steady_clock::now();
+
+		const std::string envFilePath = "./data/hdr/" + envName + ".hdr";
+		std::shared_ptr<CubeMap> unfiltered = IBLBaker::equirectToCube(HDRReader::fromFile(envFilePath, Image::Format::RGB9E5), BakeEnvMapSize);
+		const auto converted = std::chrono::steady_clock::now();
+
+		std::shared_ptr<CubeMap> prefiltered = IBLBaker::prefilter(*unfiltered);
+		const auto filtered = std::chrono::steady_clock::now();
+
+		const IBLBaker::SHCoefficients irradianceSH = IBLBaker::projectSH(*unfiltered);
+		const auto end = std::chrono::steady_clock::now();
+
+		std::printf("Baked %s: equirect->cube %.1f ms, prefilter %.1f ms (%d levels), SH %.1f ms (L00 = %.3f %.3f %.3f)\n", envName.c_str(),
+			std::chrono::duration<double, std::milli>(converted - start).count(),
+			std::chrono::duration<double, std::milli>(filtered - converted).count(),
+			prefiltered->levels(),
+			std::chrono::duration<double, std::milli>(end - filtered).count(),
+			irradianceSH[0].r, irradianceSH[0].g, irradianceSH[0].b);
+
+		// ѹд̻棬֮ʱֱӶȡ
+		EnvironmentCache::store(EnvironmentCache::makeKey(envFilePath, BakeEnvMapSize), *BakedEnvironment::fromCubeMap(*prefiltered, irradianceSH), quality);
+	}
+	return 0;
+}
@@ -7,10 +7,17 @@
 
 #include <glad/glad.h>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
 #include <stdexcept>
 #include <iostream>
 
 #include "mesh.hpp"
+#include "mesh_optimizer.hpp"
+#include "simd.hpp"
+#include "utils.hpp"
 
 
 const unsigned int ImportFlags =
@@ -24,6 +31,52 @@ const unsigned int ImportFlags =
 	aiProcess_Debone |
 	aiProcess_ValidateDataStructure;
 
+// VertexָıʱԶʧЧʽĴıʱӰ汾
+const uint32_t MeshCacheVersion = 5;
+// LODԭʼۼ԰Χ뾶ԼÿҪٵα
+const float LodMaxError = 0.05f;
+const float LodMinReduction = 0.1f;
+
+struct MeshCacheHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint64_t sourceHash;
+	uint32_t importFlags;
+	uint32_t vertexSize;
+	uint64_t numVertices;
+	uint64_t numFaces;
+	uint64_t numSubmeshes;
+	glm::vec4 boundingSphere;
+	int32_t numLods;
+	float lodErrors[Mesh::MaxLods];
+};
+
+const char* Mesh::CacheExtension = ".mesh";
+
+namespace
+{
+	int16_t quantizeSnorm16(float value)
+	{
+		return int16_t(std::round(glm::clamp(value, -1.0f, 1.0f) * 32767.0f));
+	}
+
+	// ӳ䣺λͶӰ|x|+|y|+|z|=1ϣ°ضԽ۵ࣻΪ(0,0)
+	void octahedralEncode(const glm::vec3& v, int16_t out[2])
+	{
+		const float sum = std::abs(v.x) + std::abs(v.y) + std::abs(v.z);
+		glm::vec2 e(0.0f);
+		if (sum > 0.0f) {
+			e = glm::vec2(v.x, v.y) / sum;
+			if (v.z < 0.0f) {
+				const glm::vec2 folded = 1.0f - glm::abs(glm::vec2(e.y, e.x));
+				e = glm::vec2(e.x >= 0.0f ? folded.x : -folded.x, e.y >= 0.0f ? folded.y : -folded.y);
+			}
+		}
+		out[0] = quantizeSnorm16(e.x);
+		out[1] = quantizeSnorm16(e.y);
+	}
+}
 
 struct LogStream : public Assimp::LogStream
 {
@@ -41,33 +94,176 @@ struct LogStream : public Assimp::LogStream
 	}
 };
 
-Mesh::Mesh(const aiMesh* mesh)
+Mesh::Mesh(const aiScene* scene)
 {
-	assert(mesh->HasPositions());
-	assert(mesh->HasNormals());
-
-	m_vertices.reserve(mesh->mNumVertices);
-	for (size_t i = 0; i < m_vertices.capacity(); ++i) {
-		Vertex vertex;
-		vertex.position = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
-		vertex.normal = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
-        
-		if (mesh->HasTextureCoords(0)) {
-			vertex.texcoord = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+	// ÿ񵥶ŻͳưͶȨ
+	MeshOptimizer::Statistics before = {}, after = {};
+	std::vector<std::vector<Vertex>> submeshVertices;
+	std::vector<std::vector<Face>> submeshFaces;
+	for (unsigned int m = 0; m < scene->mNumMeshes; ++m) {
+		const aiMesh* mesh = scene->mMeshes[m];
+		// aiProcess_SortByPType֮ڵ
+		if (!(mesh->mPrimitiveTypes & aiPrimitiveType_TRIANGLE)) {
+			continue;
 		}
-        // ģͶߣassimpԶ㣨aiProcess_CalcTangentSpace
-        if (mesh->HasTangentsAndBitangents()) {
-			vertex.tangent = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
-			vertex.bitangent = { mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
+		assert(mesh->HasPositions());
+		assert(mesh->HasNormals());
+
+		std::vector<Vertex> vertices;
+		vertices.reserve(mesh->mNumVertices);
+		for (size_t i = 0; i < vertices.capacity(); ++i) {
+			Vertex vertex;
+			vertex.position = { mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
+			vertex.normal = { mesh->mNormals[i].x, mesh->mNormals[i].y, mesh->mNormals[i].z };
+
+			if (mesh->HasTextureCoords(0)) {
+				vertex.texcoord = { mesh->mTextureCoords[0][i].x, mesh->mTextureCoords[0][i].y };
+			}
+			// ģͶߣassimpԶ㣨aiProcess_CalcTangentSpace
+			if (mesh->HasTangentsAndBitangents()) {
+				vertex.tangent = { mesh->mTangents[i].x, mesh->mTangents[i].y, mesh->mTangents[i].z };
+				vertex.bitangent = { mesh->mBitangents[i].x, mesh->mBitangents[i].y, mesh->mBitangents[i].z };
+			}
+			vertices.push_back(vertex);
 		}
-		m_vertices.push_back(vertex);
+
+		std::vector<Face> faces;
+		faces.reserve(mesh->mNumFaces);
+		for (size_t i = 0; i < faces.capacity(); ++i) {
+			assert(mesh->mFaces[i].mNumIndices == 3);
+			faces.push_back({ mesh->mFaces[i].mIndices[0], mesh->mFaces[i].mIndices[1], mesh->mFaces[i].mIndices[2] });
+		}
+
+		// 㻺桢overdrawȡ˳Ż񻺴汣棬ֻڵʱһ
+		MeshOptimizer::Statistics submeshBefore, submeshAfter;
+		MeshOptimizer::optimize(vertices, faces, &submeshBefore, &submeshAfter);
+		before.acmr += submeshBefore.acmr * faces.size();
+		before.atvr += submeshBefore.atvr * vertices.size();
+		after.acmr += submeshAfter.acmr * faces.size();
+		after.atvr += submeshAfter.atvr * vertices.size();
+
+		Submesh submesh;
+		submesh.baseVertex = uint32_t(m_vertices.size());
+		submesh.numVertices = uint32_t(vertices.size());
+		submesh.materialIndex = mesh->mMaterialIndex;
+		m_submeshes.push_back(submesh);
+		m_vertices.insert(m_vertices.end(), vertices.begin(), vertices.end());
+		submeshVertices.push_back(std::move(vertices));
+		submeshFaces.push_back(std::move(faces));
+	}
+	if (m_submeshes.empty()) {
+		throw std::runtime_error("Scene contains no triangle meshes");
+	}
+
+	size_t numFaces = 0;
+	for (const std::vector<Face>& faces : submeshFaces) {
+		numFaces += faces.size();
+	}
+	std::cout << "Imported " << m_submeshes.size() << " submeshes, " << m_vertices.size() << " vertices, " << numFaces << " triangles" << std::endl;
+	std::cout << "Optimized mesh: ACMR " << before.acmr / numFaces << " -> " << after.acmr / numFaces
+		<< ", ATVR " << before.atvr / m_vertices.size() << " -> " << after.atvr / m_vertices.size() << std::endl;
+
+	// ΧΪ
+	glm::vec3 boundsMin(std::numeric_limits<float>::max()), boundsMax(-std::numeric_limits<float>::max());
+	for (const Vertex& vertex : m_vertices) {
+		boundsMin = glm::min(boundsMin, vertex.position);
+		boundsMax = glm::max(boundsMax, vertex.position);
+	}
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = 0.0f;
+	for (const Vertex& vertex : m_vertices) {
+		radius = std::max(radius, glm::length(vertex.position - center));
+	}
+	m_boundingSphere = glm::vec4(center, radius);
+
+	// ÿһ򻯣ۼΪԭʼޣÿֻõʣµԤ㣻ÿ㻺
+	m_numLods = 1;
+	std::fill(m_lodErrors, m_lodErrors + MaxLods, 0.0f);
+	for (size_t i = 0; i < m_submeshes.size(); ++i) {
+		Submesh& submesh = m_submeshes[i];
+		std::vector<Face> lodFaces = std::move(submeshFaces[i]);
+		float lodError = 0.0f;
+		for (int lod = 0; lod < MaxLods; ++lod) {
+			if (lod > 0) {
+				float error = 0.0f;
+				std::vector<Face> simplified = MeshOptimizer::simplify(submeshVertices[i], lodFaces,
+					size_t(submesh.numFaces[0]) >> lod, std::max(0.0f, LodMaxError * radius - lodError), &error);
+				// ٵ̫ʱʣµĸ㶼һ
+				if (simplified.size() > lodFaces.size() * (1.0f - LodMinReduction)) {
+					for (; lod < MaxLods; ++lod) {
+						submesh.firstFace[lod] = submesh.firstFace[lod - 1];
+						submesh.numFaces[lod] = submesh.numFaces[lod - 1];
+					}
+					break;
+				}
+				MeshOptimizer::optimizeVertexCache(simplified, submeshVertices[i].size());
+				lodFaces = std::move(simplified);
+				lodError += error;
+				m_lodErrors[lod] = std::max(m_lodErrors[lod], lodError);
+				m_numLods = std::max(m_numLods, lod + 1);
+			}
+			submesh.firstFace[lod] = uint32_t(m_faces.size());
+			submesh.numFaces[lod] = uint32_t(lodFaces.size());
+			m_faces.insert(m_faces.end(), lodFaces.begin(), lodFaces.end());
+		}
+	}
+	// ĳǰֹͣʱܱǰС
+	for (int lod = 1; lod < MaxLods; ++lod) {
+		m_lodErrors[lod] = std::max(m_lodErrors[lod], m_lodErrors[lod - 1]);
+	}
+	for (int lod = 1; lod < m_numLods; ++lod) {
+		size_t lodFaces = 0;
+		for (const Submesh& submesh : m_submeshes) {
+			lodFaces += submesh.numFaces[lod];
+		}
+		std::cout << "LOD " << lod << ": " << lodFaces << " triangles, error " << m_lodErrors[lod] / radius << " of radius" << std::endl;
+	}
+
+	m_vertexData = m_vertices.data();
+	m_faceData = m_faces.data();
+	m_numVertices = m_vertices.size();
+	m_numFaces = m_faces.size();
+}
+
+size_t Mesh::maxSubmeshVertices() const
+{
+	size_t result = 0;
+	for (const Submesh& submesh : m_submeshes) {
+		result = std::max<size_t>(result, submesh.numVertices);
+	}
+	return result;
+}
+
+std::vector<Mesh::PackedVertex> Mesh::pack(glm::vec3& boundsMin, glm::vec3& boundsExtent) const
+{
+	boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax(-std::numeric_limits<float>::max());
+	for (size_t i = 0; i < m_numVertices; ++i) {
+		boundsMin = glm::min(boundsMin, m_vertexData[i].position);
+		boundsMax = glm::max(boundsMax, m_vertexData[i].position);
 	}
+	if (m_numVertices == 0) {
+		boundsMin = boundsMax = glm::vec3(0.0f);
+	}
+	boundsExtent = boundsMax - boundsMin;
+	// ĳƽʱ0ԭʱ뷶Χ޹
+	const glm::vec3 scale = glm::vec3(65535.0f) / glm::max(boundsExtent, glm::vec3(1e-20f));
 
-	m_faces.reserve(mesh->mNumFaces);
-	for (size_t i = 0; i < m_faces.capacity(); ++i) {
-		assert(mesh->mFaces[i].mNumIndices == 3);
-		m_faces.push_back({ mesh->mFaces[i].mIndices[0], mesh->mFaces[i].mIndices[1], mesh->mFaces[i].mIndices[2] });
+	std::vector<PackedVertex> packed(m_numVertices);
+	for (size_t i = 0; i < m_numVertices; ++i) {
+		const Vertex& vertex = m_vertexData[i];
+		PackedVertex& out = packed[i];
+		const glm::vec3 position = glm::round(glm::clamp((vertex.position - boundsMin) * scale, 0.0f, 65535.0f));
+		out.position[0] = uint16_t(position.x);
+		out.position[1] = uint16_t(position.y);
+		out.position[2] = uint16_t(position.z);
+		out.position[3] = glm::dot(glm::cross(vertex.normal, vertex.tangent), vertex.bitangent) < 0.0f ? 0 : 65535;
+		octahedralEncode(vertex.normal, out.normal);
+		octahedralEncode(vertex.tangent, out.tangent);
+		out.texcoord[0] = simd::floatToHalf(vertex.texcoord.x);
+		out.texcoord[1] = simd::floatToHalf(vertex.texcoord.y);
 	}
+	return packed;
 }
 
 unsigned int Mesh::sphereVAO = 0;
@@ -189,20 +385,46 @@ void Mesh::renderSphere()
 
 std::shared_ptr<Mesh> Mesh::fromFile(const std::string& filename)
 {
+	const std::shared_ptr<MappedFile> file = MappedFile::open(filename);
+	const uint64_t sourceHash = Utility::hash64(file->data(), file->size());
+	// ȡʧʱδУµ
+	std::shared_ptr<Mesh> mesh;
+	try {
+		mesh = loadCache(filename + CacheExtension, sourceHash);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+	}
+	if (mesh) {
+		return mesh;
+	}
+
 	LogStream::initialize();
 
     std::cout << "Loading mesh: " << filename << std::endl;
 
-	std::shared_ptr<Mesh> mesh;
 	Assimp::Importer importer;
 
-	const aiScene* scene = importer.ReadFile(filename, ImportFlags);
+	// ֱӴڴӳ䵼룬չΪʽʾⲿļ.gltf.binĸʽڴ浼ʧܣ˻ذ·ȡ
+	const std::string extension = filename.substr(filename.find_last_of('.') + 1);
+	const aiScene* scene = importer.ReadFileFromMemory(file->data(), file->size(), ImportFlags, extension.c_str());
+	if (!scene || !scene->HasMeshes()) {
+		scene = importer.ReadFile(filename, ImportFlags);
+	}
 	if (scene && scene->HasMeshes()) {
-		mesh = std::shared_ptr<Mesh>(new Mesh{ scene->mMeshes[0] });
+		mesh = std::shared_ptr<Mesh>(new Mesh{ scene });
 	}
 	else {
 		throw std::runtime_error("Failed to load mesh file: " + filename);
 	}
+
+	// дʧܣĿ¼ֻӰ챾μ
+	try {
+		storeCache(filename + CacheExtension, sourceHash, *mesh);
+	}
+	catch (const std::exception& e) {
+		std::cerr << e.what() << std::endl;
+	}
 	return mesh;
 }
 
@@ -215,7 +437,7 @@ std::shared_ptr<Mesh> Mesh::fromString(const std::string& data)
 
 	const aiScene* scene = importer.ReadFileFromMemory(data.c_str(), data.length(), ImportFlags, "nff");
 	if (scene && scene->HasMeshes()) {
-		mesh = std::shared_ptr<Mesh>(new Mesh{ scene->mMeshes[0] });
+		mesh = std::shared_ptr<Mesh>(new Mesh{ scene });
 	}
 	else {
         std::cout << "Failed to create mesh from string: " << data << std::endl;
@@ -223,3 +445,108 @@ std::shared_ptr<Mesh> Mesh::fromString(const std::string& data)
 	}
 	return mesh;
 }
+
+std::shared_ptr<Mesh> Mesh::loadCache(const std::string& filename, uint64_t sourceHash)
+{
+	if (!File::exists(filename)) {
+		return nullptr;
+	}
+
+	const std::shared_ptr<MappedFile> file = MappedFile::open(filename);
+	if (file->size() < sizeof(MeshCacheHeader)) {
+		return nullptr;
+	}
+
+	MeshCacheHeader header;
+	std::memcpy(&header, file->data(), sizeof(header));
+	if (std::memcmp(header.magic, "IBLM", 4) != 0 || header.version != MeshCacheVersion ||
+		header.sourceHash != sourceHash || header.importFlags != ImportFlags || header.vertexSize != sizeof(Vertex)) {
+		return nullptr;
+	}
+	// ļͷ֮㡢ļʣСȽϣ˷
+	size_t remaining = file->size() - sizeof(MeshCacheHeader);
+	if (header.numSubmeshes == 0 || header.numSubmeshes > remaining / sizeof(Submesh)) {
+		std::cout << "Truncated mesh cache file: " << filename << std::endl;
+		return nullptr;
+	}
+	const size_t submeshBytes = size_t(header.numSubmeshes) * sizeof(Submesh);
+	remaining -= submeshBytes;
+	if (header.numVertices > remaining / sizeof(Vertex)) {
+		std::cout << "Truncated mesh cache file: " << filename << std::endl;
+		return nullptr;
+	}
+	const size_t vertexBytes = size_t(header.numVertices) * sizeof(Vertex);
+	remaining -= vertexBytes;
+	if (header.numFaces > remaining / sizeof(Face)) {
+		std::cout << "Truncated mesh cache file: " << filename << std::endl;
+		return nullptr;
+	}
+	if (header.numLods < 1 || header.numLods > MaxLods) {
+		std::cout << "Corrupted mesh cache file: " << filename << std::endl;
+		return nullptr;
+	}
+
+	// ӳУϴʱٿ
+	std::shared_ptr<Mesh> mesh = std::shared_ptr<Mesh>(new Mesh());
+	const char* submeshes = file->data() + sizeof(MeshCacheHeader);
+	mesh->m_submeshes.resize(size_t(header.numSubmeshes));
+	std::memcpy(mesh->m_submeshes.data(), submeshes, submeshBytes);
+	mesh->m_file = file;
+	mesh->m_vertexData = reinterpret_cast<const Vertex*>(submeshes + submeshBytes);
+	mesh->m_faceData = reinterpret_cast<const Face*>(submeshes + submeshBytes + vertexBytes);
+	mesh->m_numVertices = size_t(header.numVertices);
+	mesh->m_numFaces = size_t(header.numFaces);
+	mesh->m_boundingSphere = header.boundingSphere;
+	mesh->m_numLods = header.numLods;
+	std::memcpy(mesh->m_lodErrors, header.lodErrors, sizeof(header.lodErrors));
+
+	// ķΧֱڼӻԽʱGPU֮⣬16λҲᱻض
+	for (const Submesh& submesh : mesh->m_submeshes) {
+		bool valid = submesh.baseVertex <= mesh->m_numVertices && submesh.numVertices <= mesh->m_numVertices - submesh.baseVertex;
+		for (int lod = 0; valid && lod < MaxLods; ++lod) {
+			valid = submesh.firstFace[lod] <= mesh->m_numFaces && submesh.numFaces[lod] <= mesh->m_numFaces - submesh.firstFace[lod];
+			const Face* faces = mesh->m_faceData + (valid ? submesh.firstFace[lod] : 0);
+			for (uint32_t i = 0; valid && i < submesh.numFaces[lod]; ++i) {
+				valid = faces[i].v1 < submesh.numVertices && faces[i].v2 < submesh.numVertices && faces[i].v3 < submesh.numVertices;
+			}
+		}
+		if (!valid) {
+			std::cout << "Corrupted mesh cache file: " << filename << std::endl;
+			return nullptr;
+		}
+	}
+	std::cout << "Loaded mesh cache: " << filename << std::endl;
+	return mesh;
+}
+
+void Mesh::storeCache(const std::string& filename, uint64_t sourceHash, const Mesh& mesh)
+{
+	MeshCacheHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "IBLM", 4);
+	header.version = MeshCacheVersion;
+	header.sourceHash = sourceHash;
+	header.importFlags = ImportFlags;
+	header.vertexSize = sizeof(Vertex);
+	header.numVertices = mesh.numVertices();
+	header.numFaces = mesh.numFaces();
+	header.numSubmeshes = mesh.submeshes().size();
+	header.boundingSphere = mesh.boundingSphere();
+	header.numLods = mesh.numLods();
+	for (int lod = 0; lod < MaxLods; ++lod) {
+		header.lodErrors[lod] = mesh.lodError(lod);
+	}
+
+	const size_t submeshBytes = mesh.submeshes().size() * sizeof(Submesh);
+	std::vector<char> content(sizeof(header) + submeshBytes + mesh.bytes());
+	char* out = content.data();
+	std::memcpy(out, &header, sizeof(header));
+	out += sizeof(header);
+	std::memcpy(out, mesh.submeshes().data(), submeshBytes);
+	out += submeshBytes;
+	std::memcpy(out, mesh.vertices(), mesh.numVertices() * sizeof(Vertex));
+	out += mesh.numVertices() * sizeof(Vertex);
+	std::memcpy(out, mesh.faces(), mesh.numFaces() * sizeof(Face));
+	File::writeBinary(filename, content.data(), content.size());
+	std::cout << "Stored mesh cache: " << filename << std::endl;
+}
@@ -6,6 +6,8 @@
 #include <vector>
 #include <glm/glm.hpp>
 
+class MappedFile;
+
 class Mesh
 {
 public:
@@ -20,17 +22,62 @@ public:
 	static_assert(sizeof(Vertex) == 14 * sizeof(float), "Wrong Vertex Size");
 	static const int NumAttributes = 5;
 
+	// ѡѹʽ20ֽڣλðΧΪ16λw渱ߵķ0Ϊ1Ϊ
+	// ߺðӳΪ16λзɲؽΪhalf
+	struct PackedVertex
+	{
+		uint16_t position[4];
+		int16_t normal[2];
+		int16_t tangent[2];
+		uint16_t texcoord[2];
+	};
+	static_assert(sizeof(PackedVertex) == 10 * sizeof(uint16_t), "Wrong PackedVertex Size");
+
 	struct Face
 	{
 		uint32_t v1, v2, v3;
 	};
 	static_assert(sizeof(Face) == 3 * sizeof(uint32_t), "Wrong Face Size");
 
+	// ʱɵLODԭʼ񣩣ÿԼΪһһ
+	static const int MaxLods = 4;
+
+	// еһ񣺶ţbaseVertex
+	// LODö㣬ֻͬټ򻯵Ĳ㼶һʹͬһ
+	struct Submesh
+	{
+		uint32_t firstFace[MaxLods];
+		uint32_t numFaces[MaxLods];
+		uint32_t baseVertex;
+		uint32_t numVertices;
+		uint32_t materialIndex;
+	};
+
+	// ĶԴļԱߣԴļϸչԴļϣ͵У
+	static const char* CacheExtension;
+
+	// 볡еȫ񣬺ϲΪһ
+	// Чʱֱӳ仺ļassimpд뻺
 	static std::shared_ptr<Mesh> fromFile(const std::string& filename);
 	static std::shared_ptr<Mesh> fromString(const std::string& data);
 
-	const std::vector<Vertex>& vertices() const { return m_vertices; }
-	const std::vector<Face>& faces() const { return m_faces; }
+	// ӻʱָļӳ䣬ֱϴ
+	const Vertex* vertices() const { return m_vertexData; }
+	const Face* faces() const { return m_faceData; }
+	size_t numVertices() const { return m_numVertices; }
+	size_t numFaces() const { return m_numFaces; }
+	size_t bytes() const { return m_numVertices * sizeof(Vertex) + m_numFaces * sizeof(Face); }
+	const std::vector<Submesh>& submeshes() const { return m_submeshes; }
+	// Ķܷʹ16λ
+	size_t maxSubmeshVertices() const;
+
+	// ΧxyzΪģwΪ뾶͸LODԭʼļλͬλ0Ϊ0
+	const glm::vec4& boundingSphere() const { return m_boundingSphere; }
+	int numLods() const { return m_numLods; }
+	float lodError(int lod) const { return m_lodErrors[lod]; }
+
+	// תΪѹʽذΧУɫ boundsMin + position * boundsExtent ԭλ
+	std::vector<PackedVertex> pack(glm::vec3& boundsMin, glm::vec3& boundsExtent) const;
 	static void renderSphere();
 	static unsigned int sphereVAO;
 	static unsigned int indexCount;
@@ -41,8 +88,21 @@ public:
 	};
 
 private:
-	Mesh(const struct aiMesh* mesh);
+	Mesh() = default;
+	Mesh(const struct aiScene* scene);
+
+	static std::shared_ptr<Mesh> loadCache(const std::string& filename, uint64_t sourceHash);
+	static void storeCache(const std::string& filename, uint64_t sourceHash, const Mesh& mesh);
 
+	std::shared_ptr<MappedFile> m_file;
 	std::vector<Vertex> m_vertices;
 	std::vector<Face> m_faces;
+	std::vector<Submesh> m_submeshes;
+	glm::vec4 m_boundingSphere;
+	int m_numLods;
+	float m_lodErrors[MaxLods];
+	const Vertex* m_vertexData;
+	const Face* m_faceData;
+	size_t m_numVertices;
+	size_t m_numFaces;
 };
@@ -0,0 +1,568 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <unordered_set>
+
+#include "mesh_optimizer.hpp"
+
+namespace
+{
+	// Forsyth㷨LRUС
+	const int ScoreCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriangleScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	const size_t NoFace = size_t(-1);
+
+	float vertexScore(int cachePosition, uint32_t remaining)
+	{
+		// ûʣεĶ㲻ٲ
+		if (remaining == 0) {
+			return -1.0f;
+		}
+		float score = 0.0f;
+		if (cachePosition >= 0) {
+			// һε̶ͬһ
+			if (cachePosition < 3) {
+				score = LastTriangleScore;
+			}
+			else {
+				score = std::pow(1.0f - float(cachePosition - 3) / (ScoreCacheSize - 3), CacheDecayPower);
+			}
+		}
+		// ʣٵĶȴ꣬Ժٵ
+		return score + ValenceBoostScale * std::pow(float(remaining), -ValenceBoostPower);
+	}
+
+	// ģGPUFIFO㻺棺ʱ¼ʱּ֮˳size㱻
+	class FifoCache
+	{
+	public:
+		FifoCache(size_t numVertices, int size)
+			: m_timestamps(numVertices, 0)
+			, m_time(uint32_t(size) + 1)
+			, m_size(uint32_t(size))
+		{}
+
+		// δеĶ
+		int access(const Mesh::Face& face)
+		{
+			return access(face.v1) + access(face.v2) + access(face.v3);
+		}
+
+		// ʱһСж㶼Ϊڻ
+		void reset()
+		{
+			m_time += m_size + 1;
+		}
+
+	private:
+		int access(uint32_t vertex)
+		{
+			if (m_time - m_timestamps[vertex] > m_size) {
+				m_timestamps[vertex] = m_time++;
+				return 1;
+			}
+			return 0;
+		}
+
+		std::vector<uint32_t> m_timestamps;
+		uint32_t m_time;
+		uint32_t m_size;
+	};
+
+	// ƽ淽̾ƽĺͣԳ4x4ֻǣweightΪ֮ͣõƽľƽ
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+		double weight;
+
+		Quadric& operator+=(const Quadric& other)
+		{
+			a2 += other.a2; ab += other.ab; ac += other.ac; ad += other.ad;
+			b2 += other.b2; bc += other.bc; bd += other.bd;
+			c2 += other.c2; cd += other.cd; d2 += other.d2;
+			weight += other.weight;
+			return *this;
+		}
+
+		void addPlane(const glm::dvec3& n, double d, double w)
+		{
+			a2 += w * n.x * n.x; ab += w * n.x * n.y; ac += w * n.x * n.z; ad += w * n.x * d;
+			b2 += w * n.y * n.y; bc += w * n.y * n.z; bd += w * n.y * d;
+			c2 += w * n.z * n.z; cd += w * n.z * d; d2 += w * d * d;
+			weight += w;
+		}
+
+		double error(const glm::vec3& p) const
+		{
+			const double x = p.x, y = p.y, z = p.z;
+			const double sum = a2 * x * x + b2 * y * y + c2 * z * z + d2
+				+ 2.0 * (ab * x * y + ac * x * z + bc * y * z + ad * x + bd * y + cd * z);
+			return weight > 0.0 ? std::max(sum / weight, 0.0) : 0.0;
+		}
+	};
+
+	struct Collapse
+	{
+		uint32_t from, to;
+		double cost;
+	};
+}
+
+void MeshOptimizer::optimize(std::vector<Mesh::Vertex>& vertices, std::vector<Mesh::Face>& faces, Statistics* before, Statistics* after)
+{
+	if (before) {
+		*before = analyze(faces, vertices.size());
+	}
+	optimizeVertexCache(faces, vertices.size());
+	optimizeOverdraw(faces, vertices);
+	optimizeVertexFetch(vertices, faces);
+	if (after) {
+		*after = analyze(faces, vertices.size());
+	}
+}
+
+MeshOptimizer::Statistics MeshOptimizer::analyze(const std::vector<Mesh::Face>& faces, size_t numVertices, int cacheSize)
+{
+	FifoCache cache(numVertices, cacheSize);
+	std::vector<bool> referenced(numVertices, false);
+	size_t misses = 0, numReferenced = 0;
+	for (const Mesh::Face& face : faces) {
+		misses += cache.access(face);
+		for (uint32_t vertex : { face.v1, face.v2, face.v3 }) {
+			if (!referenced[vertex]) {
+				referenced[vertex] = true;
+				++numReferenced;
+			}
+		}
+	}
+
+	Statistics statistics;
+	statistics.acmr = faces.empty() ? 0.0f : float(misses) / faces.size();
+	statistics.atvr = numReferenced == 0 ? 0.0f : float(misses) / numReferenced;
+	return statistics;
+}
+
+void MeshOptimizer::optimizeVertexCache(std::vector<Mesh::Face>& faces, size_t numVertices)
+{
+	const size_t numFaces = faces.size();
+
+	// ÿڵΣţÿǰremainingǻû
+	std::vector<uint32_t> remaining(numVertices, 0);
+	for (const Mesh::Face& face : faces) {
+		++remaining[face.v1];
+		++remaining[face.v2];
+		++remaining[face.v3];
+	}
+	std::vector<uint32_t> offsets(numVertices + 1, 0);
+	for (size_t vertex = 0; vertex < numVertices; ++vertex) {
+		offsets[vertex + 1] = offsets[vertex] + remaining[vertex];
+	}
+	std::vector<uint32_t> adjacency(offsets.back());
+	{
+		std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+		for (size_t f = 0; f < numFaces; ++f) {
+			adjacency[next[faces[f].v1]++] = uint32_t(f);
+			adjacency[next[faces[f].v2]++] = uint32_t(f);
+			adjacency[next[faces[f].v3]++] = uint32_t(f);
+		}
+	}
+
+	std::vector<int> cachePosition(numVertices, -1);
+	std::vector<float> score(numVertices);
+	for (size_t vertex = 0; vertex < numVertices; ++vertex) {
+		score[vertex] = vertexScore(-1, remaining[vertex]);
+	}
+	std::vector<float> faceScore(numFaces);
+	for (size_t f = 0; f < numFaces; ++f) {
+		faceScore[f] = score[faces[f].v1] + score[faces[f].v2] + score[faces[f].v3];
+	}
+
+	// 仯ʱͬڵδ
+	const auto updateScore = [&](uint32_t vertex, int position) {
+		cachePosition[vertex] = position;
+		const float newScore = vertexScore(position, remaining[vertex]);
+		const float delta = newScore - score[vertex];
+		score[vertex] = newScore;
+		for (uint32_t i = 0; i < remaining[vertex]; ++i) {
+			faceScore[adjacency[offsets[vertex] + i]] += delta;
+		}
+	};
+
+	std::vector<Mesh::Face> result;
+	result.reserve(numFaces);
+	std::vector<bool> emitted(numFaces, false);
+	std::vector<uint32_t> cache, nextCache;
+	cache.reserve(ScoreCacheSize + 3);
+	nextCache.reserve(ScoreCacheSize + 3);
+	size_t best = NoFace;
+	size_t scan = 0;
+	while (result.size() < numFaces) {
+		// еĶûʣʱȡһû¿ʼ
+		if (best == NoFace) {
+			while (emitted[scan]) {
+				++scan;
+			}
+			best = scan;
+		}
+
+		const Mesh::Face face = faces[best];
+		emitted[best] = true;
+		result.push_back(face);
+
+		const uint32_t corners[3] = { face.v1, face.v2, face.v3 };
+		for (uint32_t vertex : corners) {
+			uint32_t* begin = &adjacency[offsets[vertex]];
+			const uint32_t count = remaining[vertex];
+			for (uint32_t i = 0; i < count; ++i) {
+				if (begin[i] == best) {
+					std::swap(begin[i], begin[count - 1]);
+					break;
+				}
+			}
+			--remaining[vertex];
+		}
+
+		// õĶƵǰ棬СĶ㱻
+		nextCache.clear();
+		for (uint32_t vertex : corners) {
+			if (std::find(nextCache.begin(), nextCache.end(), vertex) == nextCache.end()) {
+				nextCache.push_back(vertex);
+			}
+		}
+		for (uint32_t vertex : cache) {
+			if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2]) {
+				nextCache.push_back(vertex);
+			}
+		}
+		for (size_t i = ScoreCacheSize; i < nextCache.size(); ++i) {
+			updateScore(nextCache[i], -1);
+		}
+		nextCache.resize(std::min<size_t>(nextCache.size(), ScoreCacheSize));
+		cache.swap(nextCache);
+
+		for (size_t i = 0; i < cache.size(); ++i) {
+			updateScore(cache[i], int(i));
+		}
+
+		// һֻӻжѡ
+		best = NoFace;
+		float bestScore = -1.0f;
+		for (uint32_t vertex : cache) {
+			for (uint32_t i = 0; i < remaining[vertex]; ++i) {
+				const uint32_t f = adjacency[offsets[vertex] + i];
+				if (faceScore[f] > bestScore) {
+					bestScore = faceScore[f];
+					best = f;
+				}
+			}
+		}
+	}
+	faces.swap(result);
+}
+
+void MeshOptimizer::optimizeOverdraw(std::vector<Mesh::Face>& faces, const std::vector<Mesh::Vertex>& vertices, float threshold)
+{
+	const size_t numFaces = faces.size();
+	if (numFaces == 0) {
+		return;
+	}
+
+	// Ӳ߽磺㶼δеΣǰ˳ԻûӰ
+	FifoCache cache(vertices.size(), CacheSize);
+	std::vector<size_t> hardBoundaries;
+	for (size_t f = 0; f < numFaces; ++f) {
+		if (cache.access(faces[f]) == 3 || f == 0) {
+			hardBoundaries.push_back(f);
+		}
+	}
+	hardBoundaries.push_back(numFaces);
+
+	// ߽磺Ӳ߽֮䣬ӴؿͷACMRεthresholdʱпп󻺴ӿտʼ
+	std::vector<size_t> clusters;
+	for (size_t i = 0; i + 1 < hardBoundaries.size(); ++i) {
+		const size_t begin = hardBoundaries[i], end = hardBoundaries[i + 1];
+		cache.reset();
+		size_t misses = 0;
+		for (size_t f = begin; f < end; ++f) {
+			misses += cache.access(faces[f]);
+		}
+		const float limit = float(misses) / (end - begin) * threshold;
+
+		cache.reset();
+		clusters.push_back(begin);
+		size_t start = begin;
+		misses = 0;
+		for (size_t f = begin; f + 1 < end; ++f) {
+			misses += cache.access(faces[f]);
+			if (float(misses) / (f - start + 1) <= limit) {
+				clusters.push_back(f + 1);
+				start = f + 1;
+				misses = 0;
+				cache.reset();
+			}
+		}
+	}
+	clusters.push_back(numFaces);
+
+	// ӽ޹صĶشƽߵľ룬ԽĴԽڵĴأȻ
+	const size_t numClusters = clusters.size() - 1;
+	std::vector<glm::vec3> centroids(numClusters, glm::vec3(0.0f));
+	std::vector<glm::vec3> normals(numClusters, glm::vec3(0.0f));
+	std::vector<float> areas(numClusters, 0.0f);
+	glm::vec3 meshCentroid(0.0f);
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < numClusters; ++c) {
+		for (size_t f = clusters[c]; f < clusters[c + 1]; ++f) {
+			const glm::vec3& p1 = vertices[faces[f].v1].position;
+			const glm::vec3& p2 = vertices[faces[f].v2].position;
+			const glm::vec3& p3 = vertices[faces[f].v3].position;
+			// ĳȨ
+			const glm::vec3 normal = glm::cross(p2 - p1, p3 - p1);
+			const float area = glm::length(normal);
+			centroids[c] += (p1 + p2 + p3) * (area / 3.0f);
+			normals[c] += normal;
+			areas[c] += area;
+		}
+		meshCentroid += centroids[c];
+		meshArea += areas[c];
+	}
+	if (meshArea > 0.0f) {
+		meshCentroid /= meshArea;
+	}
+
+	std::vector<float> metric(numClusters, 0.0f);
+	for (size_t c = 0; c < numClusters; ++c) {
+		const float normalLength = glm::length(normals[c]);
+		if (areas[c] > 0.0f && normalLength > 0.0f) {
+			metric[c] = glm::dot(centroids[c] / areas[c] - meshCentroid, normals[c] / normalLength);
+		}
+	}
+
+	std::vector<size_t> order(numClusters);
+	std::iota(order.begin(), order.end(), size_t(0));
+	std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+		return metric[a] > metric[b];
+	});
+
+	std::vector<Mesh::Face> result;
+	result.reserve(numFaces);
+	for (size_t c : order) {
+		result.insert(result.end(), faces.begin() + clusters[c], faces.begin() + clusters[c + 1]);
+	}
+	faces.swap(result);
+}
+
+void MeshOptimizer::optimizeVertexFetch(std::vector<Mesh::Vertex>& vertices, std::vector<Mesh::Face>& faces)
+{
+	const uint32_t Unused = uint32_t(-1);
+	std::vector<uint32_t> remap(vertices.size(), Unused);
+	std::vector<Mesh::Vertex> result;
+	result.reserve(vertices.size());
+	for (Mesh::Face& face : faces) {
+		for (uint32_t* index : { &face.v1, &face.v2, &face.v3 }) {
+			if (remap[*index] == Unused) {
+				remap[*index] = uint32_t(result.size());
+				result.push_back(vertices[*index]);
+			}
+			*index = remap[*index];
+		}
+	}
+	vertices.swap(result);
+}
+
+std::vector<Mesh::Face> MeshOptimizer::simplify(const std::vector<Mesh::Vertex>& vertices, const std::vector<Mesh::Face>& faces,
+	size_t targetFaces, float maxError, float* error)
+{
+	const size_t numVertices = vertices.size();
+
+	// λͬĶΪһ飬ڵһΪһжUVӷ߲
+	std::vector<uint32_t> canonical(numVertices);
+	std::vector<uint32_t> wedges(numVertices, 0);
+	{
+		std::vector<uint32_t> order(numVertices);
+		std::iota(order.begin(), order.end(), 0u);
+		const auto less = [&](uint32_t a, uint32_t b) {
+			const glm::vec3& p = vertices[a].position;
+			const glm::vec3& q = vertices[b].position;
+			return p.x != q.x ? p.x < q.x : (p.y != q.y ? p.y < q.y : p.z < q.z);
+		};
+		std::sort(order.begin(), order.end(), less);
+		for (size_t i = 0; i < numVertices; ++i) {
+			const bool same = i > 0 && vertices[order[i]].position == vertices[order[i - 1]].position;
+			canonical[order[i]] = same ? canonical[order[i - 1]] : order[i];
+			++wedges[canonical[order[i]]];
+		}
+	}
+
+	// ӷͿű߽磨ı߲ڣϵĶ̶
+	std::vector<bool> locked(numVertices, false);
+	{
+		const auto edgeKey = [](uint32_t a, uint32_t b) { return (uint64_t(a) << 32) | b; };
+		std::unordered_set<uint64_t> edges;
+		edges.reserve(faces.size() * 3);
+		for (const Mesh::Face& face : faces) {
+			const uint32_t c[3] = { canonical[face.v1], canonical[face.v2], canonical[face.v3] };
+			for (int e = 0; e < 3; ++e) {
+				edges.insert(edgeKey(c[e], c[(e + 1) % 3]));
+			}
+		}
+		for (const Mesh::Face& face : faces) {
+			const uint32_t c[3] = { canonical[face.v1], canonical[face.v2], canonical[face.v3] };
+			for (int e = 0; e < 3; ++e) {
+				if (!edges.count(edgeKey(c[(e + 1) % 3], c[e]))) {
+					locked[c[e]] = locked[c[(e + 1) % 3]] = true;
+				}
+			}
+		}
+		for (size_t v = 0; v < numVertices; ++v) {
+			if (wedges[canonical[v]] > 1) {
+				locked[canonical[v]] = true;
+			}
+		}
+	}
+
+	// ÿۼƽĶȨ
+	std::vector<Quadric> quadrics(numVertices, Quadric());
+	for (const Mesh::Face& face : faces) {
+		const glm::dvec3 p1 = vertices[face.v1].position, p2 = vertices[face.v2].position, p3 = vertices[face.v3].position;
+		const glm::dvec3 normal = glm::cross(p2 - p1, p3 - p1);
+		const double length = glm::length(normal);
+		if (length > 0.0) {
+			const glm::dvec3 n = normal / length;
+			const double d = -glm::dot(n, p1);
+			for (uint32_t v : { face.v1, face.v2, face.v3 }) {
+				quadrics[canonical[v]].addPlane(n, d, length * 0.5);
+			}
+		}
+	}
+
+	std::vector<Mesh::Face> result = faces;
+	std::vector<Collapse> candidates;
+	std::vector<uint32_t> offsets(numVertices + 1), adjacency;
+	std::vector<bool> touched(numVertices);
+	std::vector<uint32_t> collapse(numVertices);
+	const double maxCost = double(maxError) * maxError;
+	double maxApplied = 0.0;
+
+	// ÿһְ۴С۵ڵıߣȻд
+	while (result.size() > targetFaces) {
+		candidates.clear();
+		for (const Mesh::Face& face : result) {
+			const uint32_t v[3] = { face.v1, face.v2, face.v3 };
+			for (int e = 0; e < 3; ++e) {
+				const uint32_t a = v[e], b = v[(e + 1) % 3];
+				const uint32_t ca = canonical[a], cb = canonical[b];
+				Quadric q = quadrics[ca];
+				q += quadrics[cb];
+				// ֻ۵ߵĶֱӻһ˵Ķ㣬ݲ
+				if (!locked[ca]) {
+					candidates.push_back({ a, b, q.error(vertices[b].position) });
+				}
+				if (!locked[cb]) {
+					candidates.push_back({ b, a, q.error(vertices[a].position) });
+				}
+			}
+		}
+		if (candidates.empty()) {
+			break;
+		}
+		std::sort(candidates.begin(), candidates.end(), [](const Collapse& a, const Collapse& b) {
+			return a.cost < b.cost;
+		});
+
+		// ڵΣڷת
+		std::fill(offsets.begin(), offsets.end(), 0);
+		for (const Mesh::Face& face : result) {
+			++offsets[canonical[face.v1] + 1];
+			++offsets[canonical[face.v2] + 1];
+			++offsets[canonical[face.v3] + 1];
+		}
+		std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+		adjacency.resize(offsets.back());
+		{
+			std::vector<uint32_t> next(offsets.begin(), offsets.end() - 1);
+			for (size_t f = 0; f < result.size(); ++f) {
+				adjacency[next[canonical[result[f].v1]]++] = uint32_t(f);
+				adjacency[next[canonical[result[f].v2]]++] = uint32_t(f);
+				adjacency[next[canonical[result[f].v3]]++] = uint32_t(f);
+			}
+		}
+
+		std::fill(touched.begin(), touched.end(), false);
+		std::iota(collapse.begin(), collapse.end(), 0u);
+		size_t removed = 0;
+		bool changed = false;
+		for (const Collapse& candidate : candidates) {
+			if (candidate.cost > maxCost || result.size() - removed <= targetFaces) {
+				break;
+			}
+			const uint32_t from = canonical[candidate.from], to = canonical[candidate.to];
+			if (touched[from] || touched[to]) {
+				continue;
+			}
+
+			// ƶ߷λ۵
+			const glm::vec3& target = vertices[candidate.to].position;
+			bool flipped = false;
+			size_t degenerate = 0;
+			for (uint32_t i = offsets[from]; i < offsets[from + 1] && !flipped; ++i) {
+				const Mesh::Face& face = result[adjacency[i]];
+				const uint32_t v[3] = { face.v1, face.v2, face.v3 };
+				glm::vec3 before[3], after[3];
+				bool hasTarget = false;
+				for (int k = 0; k < 3; ++k) {
+					before[k] = after[k] = vertices[v[k]].position;
+					if (canonical[v[k]] == from) {
+						after[k] = target;
+					}
+					hasTarget |= canonical[v[k]] == to;
+				}
+				if (hasTarget) {
+					++degenerate;
+					continue;
+				}
+				const glm::vec3 n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+				const glm::vec3 n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+				flipped = glm::dot(n0, n1) <= 0.0f;
+			}
+			if (flipped) {
+				continue;
+			}
+
+			// ߵĶΧĶ㱾ֶ۵֤תõλò
+			for (uint32_t i = offsets[from]; i < offsets[from + 1]; ++i) {
+				const Mesh::Face& face = result[adjacency[i]];
+				touched[canonical[face.v1]] = touched[canonical[face.v2]] = touched[canonical[face.v3]] = true;
+			}
+			collapse[candidate.from] = candidate.to;
+			quadrics[to] += quadrics[from];
+			maxApplied = std::max(maxApplied, candidate.cost);
+			removed += degenerate;
+			changed = true;
+		}
+		if (!changed) {
+			break;
+		}
+
+		// дȥ˻
+		size_t count = 0;
+		for (const Mesh::Face& face : result) {
+			const Mesh::Face collapsed = { collapse[face.v1], collapse[face.v2], collapse[face.v3] };
+			const uint32_t c1 = canonical[collapsed.v1], c2 = canonical[collapsed.v2], c3 = canonical[collapsed.v3];
+			if (c1 != c2 && c2 != c3 && c1 != c3) {
+				result[count++] = collapsed;
+			}
+		}
+		result.resize(count);
+	}
+
+	if (error) {
+		*error = float(std::sqrt(maxApplied));
+	}
+	return result;
+}
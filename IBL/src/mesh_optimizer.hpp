@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+
+#include "mesh.hpp"
+
+// ʱŻΰ㻺ţٰӽ޹صڵִԼoverdraw󶥵㰴״ʹõ˳
+class MeshOptimizer
+{
+public:
+	// ͳõFIFO㻺С볣GPUpost-transform൱
+	static const int CacheSize = 16;
+
+	struct Statistics
+	{
+		float acmr;		// ÿεƽδ0.5ԽСԽ
+		float atvr;		// δ뱻ö֮ȣ1.0ԽСԽ
+	};
+
+	// ִŻǰͳ
+	static void optimize(std::vector<Mesh::Vertex>& vertices, std::vector<Mesh::Face>& faces, Statistics* before = nullptr, Statistics* after = nullptr);
+
+	static Statistics analyze(const std::vector<Mesh::Face>& faces, size_t numVertices, int cacheSize = CacheSize);
+
+	// Forsythʱ㷨ÿߵΣɶLRUеλúʣ
+	static void optimizeVertexCache(std::vector<Mesh::Face>& faces, size_t numVertices);
+
+	// ڶ㻺˳зδأACMRthresholdʱСȻĴǰ
+	// optimizeVertexCache֮
+	static void optimizeOverdraw(std::vector<Mesh::Face>& faces, const std::vector<Mesh::Vertex>& vertices, float threshold = 1.05f);
+
+	// ı۵򻯣ֻı򻯽ԭö㣻targetFacesmaxErrorʱֹͣ
+	// UVӷ졢߲ͬһλж㣩Ϳű߽ϵĶ㲻ᱻߣerrorشﵽλͬλ
+	static std::vector<Mesh::Face> simplify(const std::vector<Mesh::Vertex>& vertices, const std::vector<Mesh::Face>& faces,
+		size_t targetFaces, float maxError, float* error = nullptr);
+
+	// 㰴״γֵ˳ţȥûбõĶ
+	static void optimizeVertexFetch(std::vector<Mesh::Vertex>& vertices, std::vector<Mesh::Face>& faces);
+};
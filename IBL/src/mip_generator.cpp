@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include "mip_generator.hpp"
+#include "image.hpp"
+#include "simd.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	const float PI = 3.141592f;
+	// Kaiserİ뾶Ŀأ״
+	const float KaiserWidth = 3.0f;
+	const float KaiserAlpha = 4.0f;
+
+	// һmipmapÿͨһfloatƽ
+	struct Level
+	{
+		int width;
+		int height;
+		std::vector<std::vector<float>> planes;
+	};
+
+	// һչ
+	float besselI0(float x)
+	{
+		const float quarterX2 = 0.25f * x * x;
+		float sum = 1.0f, term = 1.0f;
+		for (int k = 1; k < 32 && term > 1e-8f * sum; ++k) {
+			term *= quarterX2 / float(k * k);
+			sum += term;
+		}
+		return sum;
+	}
+
+	float sinc(float x)
+	{
+		return std::fabs(x) < 1e-5f ? 1.0f : std::sin(PI * x) / (PI * x);
+	}
+
+	// ˲˵İ뾶ĿΪλ
+	float filterRadius(MipGenerator::Filter filter)
+	{
+		return filter == MipGenerator::Filter::Box ? 0.5f : KaiserWidth;
+	}
+
+	float filterWeight(MipGenerator::Filter filter, float x)
+	{
+		if (filter == MipGenerator::Filter::Box) {
+			return std::fabs(x) <= 0.5f ? 1.0f : 0.0f;
+		}
+		const float t = x / KaiserWidth;
+		if (std::fabs(t) >= 1.0f) {
+			return 0.0f;
+		}
+		return sinc(x) * besselI0(KaiserAlpha * std::sqrt(1.0f - t * t)) / besselI0(KaiserAlpha);
+	}
+
+	// һϵ˲ĿiĵkԴindices[k * stride + i]
+	// kתôŲstride뵽SIMDȣ8Ŀصͬһֱload벿ȨΪ0
+	struct FilterTaps
+	{
+		int count;
+		int stride;
+		std::vector<int32_t> indices;
+		std::vector<float> weights;
+	};
+
+	FilterTaps buildTaps(int srcSize, int dstSize, MipGenerator::Filter filter)
+	{
+		const float scale = float(srcSize) / float(dstSize);
+		const float support = filterRadius(filter) * scale;
+
+		FilterTaps taps;
+		taps.count = int(std::ceil(2.0f * support)) + 1;
+		taps.stride = Utility::roundToPowerOfTwo(dstSize, simd::Width);
+		taps.indices.assign(size_t(taps.count) * taps.stride, 0);
+		taps.weights.assign(size_t(taps.count) * taps.stride, 0.0f);
+
+		for (int i = 0; i < dstSize; ++i) {
+			// ԴjΪj + 0.5ԵclampԵ
+			const float center = (i + 0.5f) * scale;
+			const int first = int(std::ceil(center - support - 0.5f));
+			float sum = 0.0f;
+			for (int k = 0; k < taps.count; ++k) {
+				const int j = first + k;
+				const float weight = filterWeight(filter, (j + 0.5f - center) / scale);
+				taps.indices[size_t(k) * taps.stride + i] = std::min(std::max(j, 0), srcSize - 1);
+				taps.weights[size_t(k) * taps.stride + i] = weight;
+				sum += weight;
+			}
+			for (int k = 0; k < taps.count; ++k) {
+				taps.weights[size_t(k) * taps.stride + i] /= sum;
+			}
+		}
+		return taps;
+	}
+
+	// һз¹һΪλ
+	void normalizeRow(Level& level, int y)
+	{
+		float* nx = level.planes[0].data() + size_t(y) * level.width;
+		float* ny = level.planes[1].data() + size_t(y) * level.width;
+		float* nz = level.planes[2].data() + size_t(y) * level.width;
+		for (int x = 0; x < level.width; ++x) {
+			const float length = std::sqrt(nx[x] * nx[x] + ny[x] * ny[x] + nz[x] * nz[x]);
+			if (length > 0.0f) {
+				nx[x] /= length;
+				ny[x] /= length;
+				nz[x] /= length;
+			}
+		}
+	}
+
+	// ֱˮƽĿɷ˲ÿһ
+	void downsample(const Level& src, Level& dst, MipGenerator::Filter filter, bool renormalize)
+	{
+		using namespace simd;
+
+		const FilterTaps horizontal = buildTaps(src.width, dst.width, filter);
+		const FilterTaps vertical = buildTaps(src.height, dst.height, filter);
+
+		ThreadPool::global().parallelFor(0, dst.height, [&](int y) {
+			std::vector<float> column(src.width);
+			std::vector<float> row(horizontal.stride);
+
+			for (size_t c = 0; c < src.planes.size(); ++c) {
+				const float* srcPlane = src.planes[c].data();
+
+				// ֱԴмȨͣx
+				int x = 0;
+				for (; x + Width <= src.width; x += Width) {
+					float8 sum(0.0f);
+					for (int k = 0; k < vertical.count; ++k) {
+						const float weight = vertical.weights[size_t(k) * vertical.stride + y];
+						if (weight != 0.0f) {
+							const float* srcRow = srcPlane + size_t(vertical.indices[size_t(k) * vertical.stride + y]) * src.width;
+							sum = fmadd(float8::load(srcRow + x), float8(weight), sum);
+						}
+					}
+					sum.store(&column[x]);
+				}
+				for (; x < src.width; ++x) {
+					float sum = 0.0f;
+					for (int k = 0; k < vertical.count; ++k) {
+						const size_t tap = size_t(k) * vertical.stride + y;
+						sum += srcPlane[size_t(vertical.indices[tap]) * src.width + x] * vertical.weights[tap];
+					}
+					column[x] = sum;
+				}
+
+				// ˮƽ8Ŀһ飬gatherȡԴ
+				for (x = 0; x < dst.width; x += Width) {
+					float8 sum(0.0f);
+					for (int k = 0; k < horizontal.count; ++k) {
+						const size_t tap = size_t(k) * horizontal.stride + x;
+						sum = fmadd(gather(column.data(), int8::load(&horizontal.indices[tap])), float8::load(&horizontal.weights[tap]), sum);
+					}
+					sum.store(&row[x]);
+				}
+				std::memcpy(dst.planes[c].data() + size_t(y) * dst.width, row.data(), dst.width * sizeof(float));
+			}
+
+			// ˲󳤶ọ̇̄¹һ
+			if (renormalize) {
+				normalizeRow(dst, y);
+			}
+		});
+	}
+
+	float srgbToLinear(float value)
+	{
+		return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+	}
+
+	// ֵ16λתΪ8λsRGBֱӼĽһ
+	const std::vector<uint8_t>& linearToSRGBTable()
+	{
+		static const std::vector<uint8_t> table = []() {
+			std::vector<uint8_t> result(65536);
+			for (int i = 0; i < 65536; ++i) {
+				const float linear = i / 65535.0f;
+				const float srgb = linear <= 0.0031308f ? linear * 12.92f : 1.055f * std::pow(linear, 1.0f / 2.4f) - 0.055f;
+				result[i] = uint8_t(std::min(std::max(srgb, 0.0f), 1.0f) * 255.0f + 0.5f);
+			}
+			return result;
+		}();
+		return table;
+	}
+
+	Level decode(const Image& image, MipGenerator::ColorSpace colorSpace)
+	{
+		const int channels = image.channels();
+		float tables[2][256];
+		for (int i = 0; i < 256; ++i) {
+			const float value = i / 255.0f;
+			tables[0][i] = value;
+			switch (colorSpace) {
+			case MipGenerator::ColorSpace::SRGB:
+				tables[1][i] = srgbToLinear(value);
+				break;
+			case MipGenerator::ColorSpace::Normal:
+				tables[1][i] = value * 2.0f - 1.0f;
+				break;
+			default:
+				tables[1][i] = value;
+				break;
+			}
+		}
+
+		Level level;
+		level.width = image.width();
+		level.height = image.height();
+		level.planes.assign(channels, std::vector<float>(size_t(level.width) * level.height));
+		const unsigned char* pixels = image.pixels<unsigned char>();
+		ThreadPool::global().parallelFor(0, level.height, [&](int y) {
+			const unsigned char* src = pixels + size_t(y) * image.pitch();
+			for (int c = 0; c < channels; ++c) {
+				// alphaʼԵ
+				const float* table = tables[c < 3 ? 1 : 0];
+				float* dst = level.planes[c].data() + size_t(y) * level.width;
+				for (int x = 0; x < level.width; ++x) {
+					dst[x] = table[src[x * channels + c]];
+				}
+			}
+		});
+		return level;
+	}
+
+	std::shared_ptr<Image> encode(const Level& level, MipGenerator::ColorSpace colorSpace)
+	{
+		using namespace simd;
+
+		// ֻxyzɫؽ
+		const int channels = colorSpace == MipGenerator::ColorSpace::Normal ? 2 : int(level.planes.size());
+		std::shared_ptr<Image> image = Image::create(level.width, level.height, channels, Image::Format::UNorm8);
+		const std::vector<uint8_t>& srgbTable = linearToSRGBTable();
+		unsigned char* pixels = image->pixels<unsigned char>();
+
+		ThreadPool::global().parallelFor(0, level.height, [&](int y) {
+			unsigned char* dst = pixels + size_t(y) * image->pitch();
+			int32_t quantized[Width];
+			for (int c = 0; c < channels; ++c) {
+				const float* src = level.planes[c].data() + size_t(y) * level.width;
+				const bool srgb = colorSpace == MipGenerator::ColorSpace::SRGB && c < 3;
+				const bool normal = colorSpace == MipGenerator::ColorSpace::Normal;
+				// sRGB16λٲֱ8λ
+				const float scale = srgb ? 65535.0f : 255.0f;
+				for (int x = 0; x < level.width; x += Width) {
+					const int count = std::min(Width, level.width - x);
+					float values[Width] = {};
+					std::memcpy(values, src + x, count * sizeof(float));
+					float8 value = float8::load(values);
+					if (normal) {
+						value = fmadd(value, float8(0.5f), float8(0.5f));
+					}
+					value = min(max(value, float8(0.0f)), float8(1.0f));
+					toInt(fmadd(value, float8(scale), float8(0.5f))).store(quantized);
+					for (int lane = 0; lane < count; ++lane) {
+						dst[(x + lane) * channels + c] = srgb ? srgbTable[quantized[lane]] : uint8_t(quantized[lane]);
+					}
+				}
+			}
+		});
+		return image;
+	}
+}
+
+std::vector<std::shared_ptr<Image>> MipGenerator::generate(const std::shared_ptr<Image>& image, ColorSpace colorSpace, Filter filter)
+{
+	if (image->format() != Image::Format::UNorm8) {
+		throw std::runtime_error("Mipmap generation only supports 8-bit images");
+	}
+	if (colorSpace == ColorSpace::Normal && image->channels() < 3) {
+		throw std::runtime_error("Normal map must have at least 3 channels");
+	}
+
+	std::vector<std::shared_ptr<Image>> chain = { image };
+	const int levels = Utility::numMipmapLevels(image->width(), image->height());
+	Level current = decode(*image, colorSpace);
+	// Դͼһǵλȣ0Ҳȹһתͨ
+	if (colorSpace == ColorSpace::Normal) {
+		ThreadPool::global().parallelFor(0, current.height, [&](int y) {
+			normalizeRow(current, y);
+		});
+		chain[0] = encode(current, colorSpace);
+	}
+	for (int i = 1; i < levels; ++i) {
+		Level next;
+		next.width = std::max(current.width / 2, 1);
+		next.height = std::max(current.height / 2, 1);
+		next.planes.assign(current.planes.size(), std::vector<float>(size_t(next.width) * next.height));
+		downsample(current, next, filter, colorSpace == ColorSpace::Normal);
+		chain.push_back(encode(next, colorSpace));
+		current = std::move(next);
+	}
+	return chain;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+class Image;
+
+// CPU˵mipmapɣglGenerateTextureMipmap
+// 㶼һfloatݣԿռ䣩˲õֻʱΪ8λ
+class MipGenerator
+{
+public:
+	enum class Filter
+	{
+		Box,		// 2x2ƽglGenerateTextureMipmapͬ
+		Kaiser,		// Kaisersinc뾶Ϊ3ĿأȺʽ˲
+	};
+
+	enum class ColorSpace
+	{
+		Linear,		// ֱ˲
+		SRGB,		// RGBתԿռ˲תsRGBalpha
+		Normal,		// [0,1]3ͨߣÿ㣨0㣩¹һֻxyͨ
+	};
+
+	// mipmapNormal0imageֻ֧8λͼ
+	static std::vector<std::shared_ptr<Image>> generate(const std::shared_ptr<Image>& image, ColorSpace colorSpace, Filter filter = Filter::Kaiser);
+};
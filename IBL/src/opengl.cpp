@@ -1,5 +1,9 @@
+#include <cstddef>
+#include <cstring>
 #include <stdexcept>
 #include <memory>
+#include <chrono>
+#include <limits>
 
 //#include <glm/glm.hpp>
 //#include <glm/gtc/matrix_transform.hpp>
@@ -14,10 +18,357 @@
 #include "math.hpp"
 #include "mesh.hpp"
 #include "image.hpp"
+#include "hdr_reader.hpp"
+#include "mip_generator.hpp"
+#include "block_compressor.hpp"
+#include "texture_cache.hpp"
+#include "texture_file.hpp"
 #include "utils.hpp"
+#include "baker.hpp"
+#include "brdf_lut.hpp"
+#include "thread_pool.hpp"
 #include "opengl.hpp"
 #include "application.hpp"
 
+// ʽ決Ԥ˲һԪcs_prefilter.glsllocal_size_yһ£
+const int BakeRowsPerUnit = 32;
+// ûGPUʱ֮ǰÿزĺʱ룩
+const double DefaultBakeMsPerCost = 1e-7;
+// ̫С֡ʱ󣬲У׼
+const double BakeMinTimedCost = 1e6;
+// ϴõĳ־ӳPBOÿεĴСԼϴʱÿԪ࿽ֽ
+const size_t UploadSegmentSize = 8 << 20;
+const size_t UploadBandSize = 4 << 20;
+// ͼPBOضʱͬʱ;Ŀÿ鲻UploadBandSize
+const size_t ReadbackBandsInFlight = 4;
+// ģͼʽÿ֡ϴֽ
+const size_t TextureStreamBytesPerFrame = 4 << 20;
+// LODļͶӰĻϲֵһҪֵԸϵڱ߽л
+const float LodPixelError = 1.0f;
+const float LodHysteresis = 0.75f;
+
+// gladֻ˺profileS3TCչʽ
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_SRGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_SRGB_S3TC_DXT1_EXT 0x8C4C
+#endif
+
+namespace
+{
+	// fenceǷѾɣblockingʱһֱȵΪֹ
+	bool waitFence(GLsync fence, bool blocking)
+	{
+		GLenum result;
+		do {
+			result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, blocking ? 1000000000 : 0);
+		} while (blocking && result == GL_TIMEOUT_EXPIRED);
+		return result != GL_TIMEOUT_EXPIRED;
+	}
+
+	// ImageظʽӦϴRGB9E5ֻGL_RGBϴ
+	void pixelTransfer(Image::Format imageFormat, GLenum& format, GLenum& type)
+	{
+		switch (imageFormat) {
+		case Image::Format::Float32:
+			type = GL_FLOAT;
+			break;
+		case Image::Format::Float16:
+			type = GL_HALF_FLOAT;
+			break;
+		case Image::Format::RGB9E5:
+			format = GL_RGB;
+			type = GL_UNSIGNED_INT_5_9_9_9_REV;
+			break;
+		default:
+			type = GL_UNSIGNED_BYTE;
+			break;
+		}
+	}
+
+	// γģĿ¼Ԥȴеûʱ벢mipmap
+	// ͬʱں̨ѹд뻺棬´μֱʹãmakeKeyҪȡԴļֻûдʱ
+	TextureSource loadTextureSource(const std::string& packedFilename, MipGenerator::ColorSpace colorSpace,
+		const std::function<TextureCache::Key()>& makeKey, const std::function<std::shared_ptr<Image>()>& decode)
+	{
+		TextureSource source;
+		source.file = TextureFile::open(packedFilename);
+		if (source.file) {
+			std::cout << "Loaded texture file: " << packedFilename << std::endl;
+			return source;
+		}
+		const TextureCache::Key key = makeKey();
+		source.file = TextureCache::load(key);
+		if (!source.file) {
+			source.mipChain = MipGenerator::generate(decode(), colorSpace);
+			const std::vector<std::shared_ptr<Image>> mipChain = source.mipChain;
+			// صfuture쳣ﴦдʧܲӰ챾μ
+			ThreadPool::global().enqueue([key, mipChain, colorSpace]() {
+				try {
+					TextureCache::store(key, *BlockCompressor::compress(mipChain, colorSpace));
+				}
+				catch (const std::exception& e) {
+					std::cerr << "Failed to store texture cache: " << e.what() << std::endl;
+				}
+			});
+		}
+		return source;
+	}
+
+	// ͼļ׺ͨʽmipmapʱɫռ䣬Լǰʹõ1x1ռλɫ
+	// uniformΪյͼǱģȱʧʱرɫеĿ
+	struct TextureSlot
+	{
+		const char* suffix;
+		int channels;
+		GLenum format;
+		GLenum internalformat;
+		MipGenerator::ColorSpace colorSpace;
+		Texture ModelAssets::* texture;
+		const char* uniform;
+		unsigned char fallback[3];
+	};
+	const TextureSlot TextureSlots[ModelSource::NumTextures] = {
+		{ "_albedo", 3, GL_RGB, GL_SRGB8, MipGenerator::ColorSpace::SRGB, &ModelAssets::albedo, nullptr, { 128, 128, 128 } },
+		{ "_normal", 3, GL_RG, GL_RG8, MipGenerator::ColorSpace::Normal, &ModelAssets::normal, nullptr, { 128, 128, 255 } },
+		{ "_emission", 3, GL_RGB, GL_SRGB8, MipGenerator::ColorSpace::SRGB, &ModelAssets::emission, "haveEmission", { 0, 0, 0 } },
+		// ȡֲڶȡAOϲռλɫҲȱʧͨĬֵ
+		{ "_orm", 3, GL_RGB, GL_RGB8, MipGenerator::ColorSpace::Linear, &ModelAssets::orm, nullptr, { 255, 128, 0 } },
+	};
+	const int ORMSlot = 3;
+
+	size_t textureSourceBytes(const TextureSource& source)
+	{
+		size_t bytes = 0;
+		if (source.file) {
+			for (int level = 0; level < source.file->levels(); ++level) {
+				bytes += source.file->level(level).size;
+			}
+		}
+		for (const std::shared_ptr<Image>& image : source.mipChain) {
+			bytes += size_t(image->pitch()) * image->height();
+		}
+		return bytes;
+	}
+
+	// Ѿɵͼʧܵͼ
+	size_t modelSourceBytes(const ModelSource& source)
+	{
+		size_t bytes = 0;
+		if (source.mesh) {
+			bytes += source.mesh->bytes();
+		}
+		for (const std::shared_future<TextureSource>& texture : source.textures) {
+			if (texture.valid() && texture.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+				try {
+					bytes += textureSourceBytes(texture.get());
+				}
+				catch (const std::exception&) {
+				}
+			}
+		}
+		return bytes;
+	}
+
+	size_t meshBufferBytes(const MeshBuffer& buffer, const Mesh& mesh)
+	{
+		const size_t vertexBytes = buffer.packed ? sizeof(Mesh::PackedVertex) : sizeof(Mesh::Vertex);
+		const size_t indexBytes = buffer.indexType == GL_UNSIGNED_SHORT ? sizeof(uint16_t) : sizeof(uint32_t);
+		return mesh.numVertices() * vertexBytes + size_t(buffer.numElements) * indexBytes;
+	}
+
+	// ڸԵbaseVertexbaseInstance¼ʱţֵɫʹ
+	struct DrawElementsIndirectCommand
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// ΧľͶӰĻϣpixelsPerUnitΪ1ÿλȵڰΧʱϸһ
+	int selectLod(const MeshBuffer& buffer, int current, float scale, float distance, float pixelsPerUnit)
+	{
+		const float radius = buffer.boundingSphere.w * scale;
+		if (distance <= radius) {
+			return 0;
+		}
+		const float pixelsPerError = scale * pixelsPerUnit / distance;
+		int lod = glm::clamp(current, 0, buffer.numLods - 1);
+		while (lod > 0 && buffer.lodErrors[lod] * pixelsPerError > LodPixelError) {
+			--lod;
+		}
+		while (lod + 1 < buffer.numLods && buffer.lodErrors[lod + 1] * pixelsPerError <= LodPixelError * LodHysteresis) {
+			++lod;
+		}
+		return lod;
+	}
+
+	size_t bakedEnvironmentBytes(const BakedEnvironment& environment)
+	{
+		size_t bytes = 0;
+		for (const std::vector<uint16_t>& pixels : environment.levelPixels) {
+			bytes += pixels.size() * sizeof(uint16_t);
+		}
+		for (const std::vector<uint8_t>& blocks : environment.compressedLevels) {
+			bytes += blocks.size();
+		}
+		return bytes;
+	}
+
+	// cube mapв㼶ԴСBC6Hÿ1ֽڣRGBA16FΪ8ֽ
+	size_t cubeMapBytes(const Texture& texture, size_t bytesPerTexel)
+	{
+		size_t bytes = 0;
+		for (int level = 0; level < texture.levels; ++level) {
+			const size_t size = size_t(glm::max(texture.width >> level, 1));
+			bytes += size * size * 6 * bytesPerTexel;
+		}
+		return bytes;
+	}
+
+	// ɨģĿ¼ͼ̳߳ϲмأͬʱڵǰ̼߳ģֻͣģͼ꣬ͼʽϴ
+	std::shared_ptr<ModelSource> loadModelSource(const std::string& modelName, SceneSettings& scene)
+	{
+		std::string modelPath = "./data/models/";
+		modelPath += modelName;
+
+		std::vector<char*> modelFiles = File::readAllFilesInDirWithExt(modelPath);
+		bool haveMesh = false, haveTexture = false;
+		for (char* str : modelFiles)
+		{
+			std::string tmpStr = str;
+			int dotIdx = tmpStr.find_last_of('.');
+			std::string name = tmpStr.substr(0, dotIdx), 
+					    extName = tmpStr.substr(dotIdx);
+			
+			if (name == modelName)
+			{
+				scene.objExt = extName;
+				haveMesh = true;
+			}
+			else if (name.substr(0, tmpStr.find_last_of('_')) == modelName && extName != TextureFile::Extension)
+			{
+				scene.texExt = extName;
+				haveTexture = true;
+			}
+		}
+
+		if (modelFiles.size() == 0 || (!haveMesh && !haveTexture))
+		{
+			throw std::runtime_error("Failed to load model files: " + modelName);
+		}
+
+		std::shared_ptr<ModelSource> source = std::make_shared<ModelSource>();
+		std::string name = modelName;
+		if (name.substr(name.find_last_of('_') + 1) == "ball")
+			source->type = Mesh::Ball;
+		else
+			source->type = Mesh::ImportModel;
+
+		modelPath += "/" + modelName;
+
+		// ѡͼȼļԴͼõǷڣͼ̳߳ϲмأͬʱڵǰ̼߳ģ
+		std::cout << "Start Loading Textures:" << std::endl;
+		for (int i = 0; i < ORMSlot; ++i) {
+			const std::string filename = modelPath + TextureSlots[i].suffix + scene.texExt;
+			const std::string packedFilename = modelPath + TextureSlots[i].suffix + TextureFile::Extension;
+			if (TextureSlots[i].uniform && !File::exists(filename) && !File::exists(packedFilename)) {
+				continue;
+			}
+			const int channels = TextureSlots[i].channels;
+			const MipGenerator::ColorSpace colorSpace = TextureSlots[i].colorSpace;
+			source->textures[i] = ThreadPool::global().enqueue([filename, packedFilename, channels, colorSpace]() {
+				// ԴļֻӳһΣϣͽͬһӳ
+				std::shared_ptr<MappedFile> file;
+				return loadTextureSource(packedFilename, colorSpace,
+					[&]() {
+						file = MappedFile::open(filename);
+						return TextureCache::makeKey(file->data(), file->size(), channels, colorSpace);
+					},
+					[&]() {
+						std::cout << "Loading image: " << filename << std::endl;
+						return Image::fromMemory(file->data(), file->size(), channels);
+					});
+			}).share();
+		}
+
+		// AOֲڶȡȺϲΪһORMͼRGBȱʧͨĬֵɫֻһ
+		const char* const ormSuffixes[] = { "_occlusion", "_roughness", "_metalness" };
+		const unsigned char* const fallback = TextureSlots[ORMSlot].fallback;
+		const std::vector<unsigned char> ormDefaults(fallback, fallback + 3);
+		std::vector<std::string> ormFiles;
+		for (const char* suffix : ormSuffixes) {
+			const std::string filename = modelPath + suffix + scene.texExt;
+			if (File::exists(filename)) {
+				ormFiles.push_back(filename);
+			}
+			else {
+				ormFiles.push_back(std::string());
+				std::cout << "No " << (suffix + 1) << " texture" << std::endl;
+			}
+		}
+		const std::string ormPackedFilename = modelPath + "_orm" + TextureFile::Extension;
+		source->textures[ORMSlot] = ThreadPool::global().enqueue([ormFiles, ormDefaults, ormPackedFilename]() {
+			std::vector<std::shared_ptr<MappedFile>> files;
+			const auto makeKey = [&]() {
+				for (const std::string& filename : ormFiles) {
+					files.push_back(filename.empty() ? nullptr : MappedFile::open(filename));
+				}
+				return TextureCache::makeKey(files, 3, MipGenerator::ColorSpace::Linear);
+			};
+			return loadTextureSource(ormPackedFilename, MipGenerator::ColorSpace::Linear, makeKey, [&]() {
+				std::vector<std::shared_ptr<Image>> sources;
+				for (const std::shared_ptr<MappedFile>& file : files) {
+					sources.push_back(file ? Image::fromMemory(file->data(), file->size(), 1) : nullptr);
+				}
+				return Image::packChannels(sources, ormDefaults);
+			});
+		}).share();
+
+		if (source->type == Mesh::ImportModel)
+			source->mesh = Mesh::fromFile(modelPath + scene.objExt);
+
+		if (modelName == "cerberus")
+			source->scale = 1.0;
+		else
+			source->scale = 25.0;
+		return source;
+	}
+
+	// ʽӦinternalformatδѹʽҪϴõformat
+	GLenum textureFileFormat(const TextureFile& file, GLenum& format)
+	{
+		const bool srgb = file.isSRGB();
+		format = GL_NONE;
+		switch (file.format()) {
+		case TextureFile::Format::BC1:
+			return srgb ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+		case TextureFile::Format::BC4:
+			return GL_COMPRESSED_RED_RGTC1;
+		case TextureFile::Format::BC5:
+			return GL_COMPRESSED_RG_RGTC2;
+		case TextureFile::Format::BC7:
+			return srgb ? GL_COMPRESSED_SRGB_ALPHA_BPTC_UNORM : GL_COMPRESSED_RGBA_BPTC_UNORM;
+		case TextureFile::Format::BC6H:
+			return GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT;
+		case TextureFile::Format::R8:
+			format = GL_RED;
+			return GL_R8;
+		case TextureFile::Format::RG8:
+			format = GL_RG;
+			return GL_RG8;
+		case TextureFile::Format::RGB8:
+			format = GL_RGB;
+			return srgb ? GL_SRGB8 : GL_RGB8;
+		default:
+			format = GL_RGBA;
+			return srgb ? GL_SRGB8_ALPHA8 : GL_RGBA8;
+		}
+	}
+}
 
 
 struct TransformUB
@@ -34,9 +385,27 @@ struct ShadingUB
 		glm::vec4 radiance;
 	} lights[SceneSettings::NumLights];
 	glm::vec4 eyePosition;
+	glm::vec4 irradianceSH[IBLBaker::NumSHCoefficients];
 };
 
-Renderer::Renderer(){}
+int TextureSource::width() const
+{
+	return file ? file->width() : mipChain.front()->width();
+}
+
+int TextureSource::height() const
+{
+	return file ? file->height() : mipChain.front()->height();
+}
+
+int TextureSource::levels() const
+{
+	return file ? file->levels() : int(mipChain.size());
+}
+
+Renderer::Renderer()
+	: m_bakeMsPerCost(DefaultBakeMsPerCost)
+{}
 
 GLFWwindow* Renderer::initialize(int width, int height, int maxSamples)
 {
@@ -116,24 +485,30 @@ void Renderer::shutdown()
 	m_pbrShader.deleteProgram();
 	m_tonemapShader.deleteProgram();
 	m_prefilterShader.deleteProgram();
-	m_irradianceMapShader.deleteProgram();
+	m_shProjectShader.deleteProgram();
+	m_shReduceShader.deleteProgram();
 
 	glDeleteBuffers(1, &m_transformUB);
 	glDeleteBuffers(1, &m_shadingUB);
+	cancelEnvironmentBake();
+	for (const BakeTimer& timer : m_bakeTimers) {
+		glDeleteQueries(1, &timer.query);
+	}
+	m_bakeTimers.clear();
+	m_uploadRing.destroy();
+	glDeleteBuffers(1, &m_prefilterSamplesSSBO);
+	glDeleteBuffers(1, &m_shPartialSumsSSBO);
+	glDeleteBuffers(1, &m_shCoefficientsSSBO);
 
 	deleteMeshBuffer(m_skybox);
-	deleteMeshBuffer(m_pbrModel);
-
-	deleteTexture(m_envTexture);
-	deleteTexture(m_irmapTexture);
 	deleteTexture(m_BRDF_LUT);
 
-	deleteTexture(m_albedoTexture);
-	deleteTexture(m_normalTexture);
-	deleteTexture(m_metalnessTexture);
-	deleteTexture(m_roughnessTexture);
-	deleteTexture(m_emissionTexture);
-	deleteTexture(m_occlusionTexture);
+	// еGLҪǰɾ
+	m_textureStreams.clear();
+	m_model.reset();
+	m_environment.reset();
+	m_gpuCache.clear();
+	m_cpuCache.clear();
 
 	ImGui_ImplOpenGL3_Shutdown();
 	ImGui_ImplGlfw_Shutdown();
@@ -144,8 +519,6 @@ void Renderer::setup(const SceneSettings& scene)
 {
 	// ͼС
 	m_EnvMapSize = 1024;	// 2Ĵ
-	m_IrradianceMapSize = 32;
-	m_BRDF_LUT_Size = 512;
 
 	// OpenGLȫ״̬
 	glEnable(GL_CULL_FACE);
@@ -159,16 +532,25 @@ void Renderer::setup(const SceneSettings& scene)
 	m_transformUB = createUniformBuffer<TransformUB>();
 	m_shadingUB = createUniformBuffer<ShadingUB>();
 
+	// гͶӰõSSBOÿwork group(16x16)һݲֺͣԼյ9ϵ
+	const int shGroups = glm::max(1, IBLBaker::SHProjectionSize / 16);
+	m_shPartialSumsSSBO = createStorageBuffer(shGroups * shGroups * 6 * IBLBaker::NumSHCoefficients * sizeof(glm::vec4));
+	m_shCoefficientsSSBO = createStorageBuffer(IBLBaker::NumSHCoefficients * sizeof(glm::vec4));
+	buildPrefilterSamples();
+	m_uploadRing.create(UploadSegmentSize);
+	m_gpuCache.setBudget(size_t(scene.gpuCacheBudget) << 20);
+	m_cpuCache.setBudget(size_t(scene.cpuCacheBudget) << 20);
+
 	// غպСpbrɫ
 	// TODO: recompile warningһ
 	m_tonemapShader = Shader("./data/shaders/postprocess_vs.glsl", "./data/shaders/postprocess_fs.glsl");
 	m_pbrShader = Shader("./data/shaders/pbr_vs.glsl", "./data/shaders/pbr_fs.glsl");
 	m_skyboxShader = Shader("./data/shaders/skybox_vs.glsl", "./data/shaders/skybox_fs.glsl");
 
-	// prefilter irradianceMapequirect Projectɫ
+	// prefilterгͶӰɫ
 	m_prefilterShader = ComputeShader("./data/shaders/cs_prefilter.glsl");
-	m_irradianceMapShader = ComputeShader("./data/shaders/cs_irradiance_map.glsl");
-	m_equirectToCubeShader = ComputeShader("./data/shaders/cs_equirect2cube.glsl");
+	m_shProjectShader = ComputeShader("./data/shaders/cs_sh_project.glsl");
+	m_shReduceShader = ComputeShader("./data/shaders/cs_sh_reduce.glsl");
 
 	std::cout << "Start Loading Models:" << std::endl;
 	// պģ
@@ -177,7 +559,7 @@ void Renderer::setup(const SceneSettings& scene)
 	// PBRģԼͼ
 	loadModels(scene.objName, const_cast<SceneSettings&>(scene));
 
-	// ػͼͬʱԤprefilterԼirradiance map
+	// ػͼͬʱԤprefilterԼirradianceгϵ
 	loadSceneHdr(scene.envName);
 
 	// Ԥ߹ⲿҪLook Up Texture (cosTheta, roughness)
@@ -189,7 +571,11 @@ void Renderer::setup(const SceneSettings& scene)
 
 void Renderer::render(GLFWwindow* window, const Camera& camera, const SceneSettings& scene)
 {
-	
+	// ԤʱƽڽеĻ決ǰʹþɵĻͼ
+	updateEnvironmentBake(scene.envBakeBudget);
+	// ϴ̨ɵģͼ
+	updateTextureStreaming();
+
 	TransformUB transformUniforms;
 	transformUniforms.model = 
 		glm::eulerAngleXY(glm::radians(scene.objectPitch), glm::radians(scene.objectYaw))
@@ -212,6 +598,9 @@ void Renderer::render(GLFWwindow* window, const Camera& camera, const SceneSetti
 			shadingUniforms.lights[i].radiance = glm::vec4{};
 		}
 	}
+	for (int i = 0; i < IBLBaker::NumSHCoefficients; ++i) {
+		shadingUniforms.irradianceSH[i] = m_environment->irradianceSH[i];
+	}
 	glNamedBufferSubData(m_shadingUB, 0, sizeof(ShadingUB), &shadingUniforms);
 	
 	// Ⱦõ֡壬лƵȱframebuffer
@@ -225,28 +614,32 @@ void Renderer::render(GLFWwindow* window, const Camera& camera, const SceneSetti
 	// պ
 	m_skyboxShader.use();
 	glDisable(GL_DEPTH_TEST);
-	glBindTextureUnit(0, m_envTexture.id);
-	glBindVertexArray(m_skybox.vao);
-	glDrawElements(GL_TRIANGLES, m_skybox.numElements, GL_UNSIGNED_INT, 0);
+	glBindTextureUnit(0, m_environment->texture.id);
+	drawMeshBuffer(m_skybox);
 
 	// ģ
 	m_pbrShader.use();
 	glEnable(GL_DEPTH_TEST);
-	glBindTextureUnit(0, m_albedoTexture.id);
-	glBindTextureUnit(1, m_normalTexture.id);
-	glBindTextureUnit(2, m_metalnessTexture.id);
-	glBindTextureUnit(3, m_roughnessTexture.id);
-	glBindTextureUnit(4, m_envTexture.id);
-	glBindTextureUnit(5, m_irmapTexture.id);
+	glBindTextureUnit(0, m_model->albedo.id);
+	glBindTextureUnit(1, m_model->normal.id);
+	glBindTextureUnit(2, m_model->orm.id);
+	glBindTextureUnit(4, m_environment->texture.id);
 	glBindTextureUnit(6, m_BRDF_LUT.id);
-	glBindTextureUnit(7, m_occlusionTexture.id);
-	glBindTextureUnit(8, m_emissionTexture.id);
+	glBindTextureUnit(8, m_model->emission.id);
 	
 	if (scene.objType == Mesh::ImportModel) {
-		glBindVertexArray(m_pbrModel.vao);
-		glDrawElements(GL_TRIANGLES, m_pbrModel.numElements, GL_UNSIGNED_INT, 0);
+		const MeshBuffer& mesh = m_model->mesh;
+		const glm::vec3 center = glm::vec3(transformUniforms.model * glm::vec4(glm::vec3(mesh.boundingSphere), 1.0f));
+		const float pixelsPerUnit = 0.5f * m_framebuffer.height / std::tan(glm::radians(camera.Zoom) * 0.5f);
+		m_model->lod = selectLod(mesh, m_model->lod, scene.objectScale, glm::length(center - eyePosition), pixelsPerUnit);
+
+		m_pbrShader.setBool("packedVertices", mesh.packed);
+		m_pbrShader.setVec3("positionOffset", mesh.boundsMin);
+		m_pbrShader.setVec3("positionScale", mesh.boundsExtent);
+		drawMeshBuffer(mesh, m_model->lod);
 	}
 	else if (scene.objType == Mesh::Ball) {
+		m_pbrShader.setBool("packedVertices", false);
 		Mesh::renderSphere();
 	}
 	
@@ -297,7 +690,7 @@ void Renderer::renderImgui(SceneSettings& scene)
 					scene.envName = scene.envNames[i];
 					if (strcmp(scene.preEnv, scene.envName))
 					{
-						loadSceneHdr(scene.envName);
+						beginEnvironmentBake(scene.envName, false);
 						strcpy(scene.preEnv, scene.envName);
 					}
 				}
@@ -306,6 +699,15 @@ void Renderer::renderImgui(SceneSettings& scene)
 			}
 			ImGui::EndCombo();
 		}
+		ImGui::SliderFloat("Bake Budget (ms)", &scene.envBakeBudget, 0.5f, 16.0f);
+		if (m_envBake.active) {
+			if (m_envBake.source.valid()) {
+				ImGui::Text("Loading %s...", m_envBake.name.c_str());
+			}
+			else {
+				ImGui::Text("Baking %s: %d / %d", m_envBake.name.c_str(), m_envBake.doneUnits, m_envBake.numUnits);
+			}
+		}
 
 		// лCombox
 		if (ImGui::BeginCombo("Object", scene.objName)) {
@@ -325,6 +727,22 @@ void Renderer::renderImgui(SceneSettings& scene)
 			}
 			ImGui::EndCombo();
 		}
+
+		if (ImGui::Checkbox("Packed Vertices", &scene.packedVertices)) {
+			loadModels(scene.objName, scene);
+		}
+		ImGui::Text("Vertex Size: %d bytes", int(scene.packedVertices ? sizeof(Mesh::PackedVertex) : sizeof(Mesh::Vertex)));
+		if (scene.objType == Mesh::ImportModel) {
+			ImGui::Text("LOD: %d / %d", m_model->lod, m_model->mesh.numLods);
+		}
+
+		// лʾģͻ򻷾ʱֱʹû棬ԤСʱ̭
+		ImGui::SliderFloat("VRAM Cache (MB)", &scene.gpuCacheBudget, 0.0f, 4096.0f);
+		ImGui::SliderFloat("RAM Cache (MB)", &scene.cpuCacheBudget, 0.0f, 4096.0f);
+		m_gpuCache.setBudget(size_t(scene.gpuCacheBudget) << 20);
+		m_cpuCache.setBudget(size_t(scene.cpuCacheBudget) << 20);
+		ImGui::Text("VRAM Cache: %.1f MB, %d assets", m_gpuCache.usage() / double(1 << 20), int(m_gpuCache.count()));
+		ImGui::Text("RAM Cache: %.1f MB, %d assets", m_cpuCache.usage() / double(1 << 20), int(m_cpuCache.count()));
 		
 		ImGui::End();
 	}
@@ -347,20 +765,43 @@ Texture Renderer::createTexture(GLenum target, int width, int height, GLenum int
 	return texture;
 }
 
-Texture Renderer::createTexture(const std::shared_ptr<class Image>& image, GLenum format, GLenum internalformat, int levels) const
+Texture Renderer::createTexture(const TextureSource& source, GLenum internalformat) const
 {
-	Texture texture = createTexture(GL_TEXTURE_2D, image->width(), image->height(), internalformat, levels);
-	if (image->isHDR()) {
-		glTextureSubImage2D(texture.id, 0, 0, 0, texture.width, texture.height, format, GL_FLOAT, image->pixels<float>());
-	}
-	else {
-		glTextureSubImage2D(texture.id, 0, 0, 0, texture.width, texture.height, format, GL_UNSIGNED_BYTE, image->pixels<unsigned char>());
+	// mipmapѾCPUɺã֮ϴٵglGenerateTextureMipmap
+	GLenum format;
+	if (source.file) {
+		internalformat = textureFileFormat(*source.file, format);
 	}
+	return createTexture(GL_TEXTURE_2D, source.width(), source.height(), internalformat, source.levels());
+}
 
-	if (texture.levels > 1) {
-		glGenerateTextureMipmap(texture.id);
+size_t Renderer::uploadTextureLevel(const Texture& texture, const TextureSource& source, int level, GLenum format)
+{
+	// ֮У3ͨ8λhalfͼгȲһ4ı
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	size_t bytes;
+	if (source.file) {
+		// ֱӴڴӳϴûм俽
+		const TextureFile& file = *source.file;
+		const TextureFile::Level& data = file.level(level);
+		const GLenum internalformat = textureFileFormat(file, format);
+		if (file.isCompressed()) {
+			glCompressedTextureSubImage2D(texture.id, level, 0, 0, data.width, data.height, internalformat, GLsizei(data.size), data.data);
+		}
+		else {
+			glTextureSubImage2D(texture.id, level, 0, 0, data.width, data.height, format, GL_UNSIGNED_BYTE, data.data);
+		}
+		bytes = data.size;
 	}
-	return texture;
+	else {
+		const Image& image = *source.mipChain[level];
+		GLenum type;
+		pixelTransfer(image.format(), format, type);
+		glTextureSubImage2D(texture.id, level, 0, 0, image.width(), image.height(), format, type, image.pixels<unsigned char>());
+		bytes = size_t(image.pitch()) * image.height();
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	return bytes;
 }
 
 void Renderer::deleteTexture(Texture& texture)
@@ -450,27 +891,77 @@ void Renderer::deleteFrameBuffer(FrameBuffer& fb)
 	std::memset(&fb, 0, sizeof(FrameBuffer));
 }
 
-MeshBuffer Renderer::createMeshBuffer(const std::shared_ptr<class Mesh>& mesh)
+MeshBuffer Renderer::createMeshBuffer(const std::shared_ptr<class Mesh>& mesh, bool packed)
 {
 	MeshBuffer buffer;
-	buffer.numElements = static_cast<GLuint>(mesh->faces().size()) * 3;
+	buffer.numElements = static_cast<GLuint>(mesh->numFaces()) * 3;
+	buffer.packed = packed;
+
+	buffer.numLods = mesh->numLods();
+	buffer.boundingSphere = mesh->boundingSphere();
+	for (int lod = 0; lod < Mesh::MaxLods; ++lod) {
+		buffer.lodErrors[lod] = mesh->lodError(lod);
+	}
 
-	const size_t vertexDataSize = mesh->vertices().size() * sizeof(Mesh::Vertex);
-	const size_t indexDataSize = mesh->faces().size() * sizeof(Mesh::Face);
+	std::vector<DrawElementsIndirectCommand> commands;
+	for (int lod = 0; lod < buffer.numLods; ++lod) {
+		for (const Mesh::Submesh& submesh : mesh->submeshes()) {
+			commands.push_back({ submesh.numFaces[lod] * 3, 1, submesh.firstFace[lod] * 3, GLint(submesh.baseVertex), submesh.materialIndex });
+		}
+	}
+	buffer.drawCount = GLsizei(mesh->submeshes().size());
+	glCreateBuffers(1, &buffer.indirect);
+	glNamedBufferStorage(buffer.indirect, commands.size() * sizeof(DrawElementsIndirectCommand), commands.data(), 0);
 
 	glCreateBuffers(1, &buffer.vbo);
-	glNamedBufferStorage(buffer.vbo, vertexDataSize, reinterpret_cast<const void*>(&mesh->vertices()[0]), 0);
 	glCreateBuffers(1, &buffer.ibo);
-	glNamedBufferStorage(buffer.ibo, indexDataSize, reinterpret_cast<const void*>(&mesh->faces()[0]), 0);
-
 	glCreateVertexArrays(1, &buffer.vao);
 	glVertexArrayElementBuffer(buffer.vao, buffer.ibo);
-	for (int i = 0; i < Mesh::NumAttributes; ++i) {
-		glVertexArrayVertexBuffer(buffer.vao, i, buffer.vbo, i * sizeof(glm::vec3), sizeof(Mesh::Vertex));
-		glEnableVertexArrayAttrib(buffer.vao, i);
-		glVertexArrayAttribFormat(buffer.vao, i, i == 2 ? 2 : 3, GL_FLOAT, GL_FALSE, 0);
-		glVertexArrayAttribBinding(buffer.vao, i, i);
+	if (packed) {
+		const std::vector<Mesh::PackedVertex> vertices = mesh->pack(buffer.boundsMin, buffer.boundsExtent);
+		glNamedBufferStorage(buffer.vbo, vertices.size() * sizeof(Mesh::PackedVertex), vertices.data(), 0);
+
+		// λáߺ߰һȡɫн
+		struct Attribute { GLint size; GLenum type; GLboolean normalized; GLuint offset; };
+		const Attribute attributes[] = {
+			{ 4, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(Mesh::PackedVertex, position) },
+			{ 4, GL_SHORT, GL_TRUE, offsetof(Mesh::PackedVertex, normal) },
+			{ 2, GL_HALF_FLOAT, GL_FALSE, offsetof(Mesh::PackedVertex, texcoord) },
+		};
+		glVertexArrayVertexBuffer(buffer.vao, 0, buffer.vbo, 0, sizeof(Mesh::PackedVertex));
+		for (int i = 0; i < 3; ++i) {
+			glEnableVertexArrayAttrib(buffer.vao, i);
+			glVertexArrayAttribFormat(buffer.vao, i, attributes[i].size, attributes[i].type, attributes[i].normalized, attributes[i].offset);
+			glVertexArrayAttribBinding(buffer.vao, i, 0);
+		}
+
+		if (mesh->maxSubmeshVertices() <= 65536) {
+			const uint32_t* indices = &mesh->faces()->v1;
+			const std::vector<uint16_t> shortIndices(indices, indices + buffer.numElements);
+			glNamedBufferStorage(buffer.ibo, shortIndices.size() * sizeof(uint16_t), shortIndices.data(), 0);
+			buffer.indexType = GL_UNSIGNED_SHORT;
+			return buffer;
+		}
+	}
+	else {
+		// ӻʱֱӴļӳϴ
+		glNamedBufferStorage(buffer.vbo, mesh->numVertices() * sizeof(Mesh::Vertex), mesh->vertices(), 0);
+
+		const GLuint offsets[Mesh::NumAttributes] = {
+			offsetof(Mesh::Vertex, position),
+			offsetof(Mesh::Vertex, normal),
+			offsetof(Mesh::Vertex, texcoord),
+			offsetof(Mesh::Vertex, tangent),
+			offsetof(Mesh::Vertex, bitangent),
+		};
+		glVertexArrayVertexBuffer(buffer.vao, 0, buffer.vbo, 0, sizeof(Mesh::Vertex));
+		for (int i = 0; i < Mesh::NumAttributes; ++i) {
+			glEnableVertexArrayAttrib(buffer.vao, i);
+			glVertexArrayAttribFormat(buffer.vao, i, i == 2 ? 2 : 3, GL_FLOAT, GL_FALSE, offsets[i]);
+			glVertexArrayAttribBinding(buffer.vao, i, 0);
+		}
 	}
+	glNamedBufferStorage(buffer.ibo, mesh->numFaces() * sizeof(Mesh::Face), mesh->faces(), 0);
 	return buffer;
 }
 
@@ -485,9 +976,21 @@ void Renderer::deleteMeshBuffer(MeshBuffer& buffer)
 	if (buffer.ibo) {
 		glDeleteBuffers(1, &buffer.ibo);
 	}
+	if (buffer.indirect) {
+		glDeleteBuffers(1, &buffer.indirect);
+	}
 	std::memset(&buffer, 0, sizeof(MeshBuffer));
 }
 
+void Renderer::drawMeshBuffer(const MeshBuffer& buffer, int lod)
+{
+	const size_t offset = size_t(lod) * buffer.drawCount * sizeof(DrawElementsIndirectCommand);
+	glBindVertexArray(buffer.vao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, buffer.indirect);
+	glMultiDrawElementsIndirect(GL_TRIANGLES, buffer.indexType, reinterpret_cast<const void*>(offset), buffer.drawCount, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
 GLuint Renderer::createUniformBuffer(const void* data, size_t size)
 {
 	GLuint ubo;
@@ -496,203 +999,616 @@ GLuint Renderer::createUniformBuffer(const void* data, size_t size)
 	return ubo;
 }
 
+GLuint Renderer::createStorageBuffer(size_t size, const void* data)
+{
+	GLuint ssbo;
+	glCreateBuffers(1, &ssbo);
+	glNamedBufferStorage(ssbo, size, data, 0);
+	return ssbo;
+}
+
 void Renderer::loadModels(const std::string& modelName, SceneSettings& scene)
 {
-	deleteMeshBuffer(m_pbrModel);
-	deleteTexture(m_albedoTexture);
-	deleteTexture(m_normalTexture);
-	deleteTexture(m_metalnessTexture);
-	deleteTexture(m_roughnessTexture);
-	deleteTexture(m_emissionTexture);
-	deleteTexture(m_occlusionTexture);
+	// ʾģֱӴԴ滺ȡأԴ滺̭ڴ滺滹ʱļֻϴ
+	const std::string modelPath = "./data/models/" + modelName;
+	std::shared_ptr<ModelAssets> model = m_gpuCache.find<ModelAssets>(modelPath);
+	// ʽлϴеľɰ汾滻
+	if (model && model->mesh.vao != 0 && model->mesh.packed != scene.packedVertices) {
+		model.reset();
+	}
+	if (!model) {
+		std::shared_ptr<ModelSource> source = m_cpuCache.find<ModelSource>(modelPath);
+		if (!source) {
+			source = loadModelSource(modelName, scene);
+			m_cpuCache.insert(modelPath, source, modelSourceBytes(*source));
+		}
 
-	std::string modelPath = "./data/models/";
-	modelPath += modelName;
+		// ̭ҲʾʱɾGL
+		model.reset(new ModelAssets(), [](ModelAssets* assets) {
+			deleteMeshBuffer(assets->mesh);
+			deleteTexture(assets->albedo);
+			deleteTexture(assets->normal);
+			deleteTexture(assets->orm);
+			deleteTexture(assets->emission);
+			delete assets;
+		});
+		model->type = source->type;
+		model->scale = source->scale;
+		model->lod = 0;
+		model->bytes = 0;
+		if (source->mesh) {
+			model->mesh = createMeshBuffer(source->mesh, scene.packedVertices);
+			model->bytes += meshBufferBytes(model->mesh, *source->mesh);
+		}
 
-	std::vector<char*> modelFiles = File::readAllFilesInDirWithExt(modelPath);
-	bool haveMesh = false, haveTexture = false;
-	for (char* str : modelFiles)
-	{
-		std::string tmpStr = str;
-		int dotIdx = tmpStr.find_last_of('.');
-		std::string name = tmpStr.substr(0, dotIdx), 
-				    extName = tmpStr.substr(dotIdx);
-		
-		if (name == modelName)
-		{
-			scene.objExt = extName;
-			haveMesh = true;
+		// ͼ1x1ռλɫɺʽ滻
+		for (int i = 0; i < ModelSource::NumTextures; ++i) {
+			const TextureSlot& slot = TextureSlots[i];
+			if (!source->textures[i].valid()) {
+				std::cout << "No " << (slot.suffix + 1) << " texture" << std::endl;
+				continue;
+			}
+			Texture& texture = (*model).*slot.texture;
+			texture = createTexture(GL_TEXTURE_2D, 1, 1, slot.internalformat, 1);
+			glTextureSubImage2D(texture.id, 0, 0, 0, 1, 1, GL_RGB, GL_UNSIGNED_BYTE, slot.fallback);
+			m_textureStreams.push_back({ modelPath, model, source, i, -1 });
 		}
-		else if (name.substr(0, tmpStr.find_last_of('_')) == modelName)
-		{
-			scene.texExt = extName;
-			haveTexture = true;
+		m_gpuCache.insert(modelPath, model, model->bytes);
+	}
+
+	m_model = model;
+	scene.objType = model->type;
+	scene.objectScale = model->scale;
+	m_pbrShader.use();
+	for (const TextureSlot& slot : TextureSlots) {
+		if (slot.uniform) {
+			m_pbrShader.setBool(slot.uniform, ((*model).*slot.texture).id != 0);
 		}
 	}
+}
 
-	if (modelFiles.size() == 0 || (!haveMesh && !haveTexture))
-	{
-		throw std::runtime_error("Failed to load model files: " + modelName);
-	}
-
-	std::string name = modelName;
-	if (name.substr(name.find_last_of('_') + 1) == "ball")
-		scene.objType = Mesh::Ball;
-	else
-		scene.objType = Mesh::ImportModel;
-
-	modelPath += "/" + modelName;
-	if (scene.objType == Mesh::ImportModel)
-		m_pbrModel = createMeshBuffer(Mesh::fromFile(modelPath + scene.objExt));
-
-	if (modelName == "cerberus")
-		scene.objectScale = 1.0;
-	else
-		scene.objectScale = 25.0;
-
-	// ͼ
-	std::cout << "Start Loading Textures:" << std::endl;
-	m_albedoTexture = createTexture(
-		Image::fromFile(modelPath + "_albedo" + scene.texExt, 3),
-		GL_RGB, GL_SRGB8
-	);
-	m_normalTexture = createTexture(
-		Image::fromFile(modelPath + "_normal" + scene.texExt, 3),
-		GL_RGB, GL_RGB8
-	);
+void Renderer::updateTextureStreaming()
+{
+	// ÿ֡ϴTextureStreamBytesPerFrameֽڣϴһ㣬֤ÿͼƽ
+	size_t budget = TextureStreamBytesPerFrame;
+	bool progressed = false;
+	for (auto it = m_textureStreams.begin(); it != m_textureStreams.end();) {
+		TextureStream& stream = *it;
+		const std::shared_ptr<ModelAssets> model = stream.model.lock();
+		if (!model) {
+			it = m_textureStreams.erase(it);
+			continue;
+		}
 
-	m_pbrShader.use();
-	try {
-		m_metalnessTexture = createTexture(
-			Image::fromFile(modelPath + "_metalness" + scene.texExt, 1),
-			GL_RED, GL_R8
-		);
-		m_pbrShader.setBool("haveMetalness", true);
+		const TextureSlot& slot = TextureSlots[stream.slot];
+		Texture& texture = (*model).*slot.texture;
+		const std::shared_future<TextureSource>& future = stream.source->textures[stream.slot];
+		if (stream.nextLevel < 0) {
+			// Ⱥ̨̼߳꣬ĲͼСһϴ֮ǰʹռλͼ
+			if (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+				++it;
+				continue;
+			}
+			try {
+				future.get();
+			}
+			catch (const std::exception& e) {
+				// ʧʱռλͼ
+				std::cerr << "Failed to load " << (slot.suffix + 1) << " texture: " << e.what() << std::endl;
+				it = m_textureStreams.erase(it);
+				continue;
+			}
+			// ·ͼδ壬Сһ㲻Ԥƣ滻ռλͼͬһ֡ϴ
+			deleteTexture(texture);
+			texture = createTexture(future.get(), slot.internalformat);
+			stream.nextLevel = texture.levels - 1;
+			model->bytes += textureSourceBytes(future.get());
+			m_gpuCache.resize(stream.key, model->bytes);
+			m_cpuCache.resize(stream.key, modelSourceBytes(*stream.source));
+		}
+
+		// Сϴbase levelϴһߣLODbase levelĳߴ㣬Ҫmin LOD
+		bool first = (stream.nextLevel == texture.levels - 1);
+		while (stream.nextLevel >= 0 && (budget > 0 || !progressed || first)) {
+			const size_t bytes = uploadTextureLevel(texture, future.get(), stream.nextLevel, slot.format);
+			glTextureParameteri(texture.id, GL_TEXTURE_BASE_LEVEL, stream.nextLevel);
+			budget -= glm::min(budget, bytes);
+			progressed = true;
+			first = false;
+			--stream.nextLevel;
+		}
+		if (stream.nextLevel < 0) {
+			it = m_textureStreams.erase(it);
+		}
+		else {
+			++it;
+		}
 	}
-	catch (std::runtime_error) {
-		std::cout << "No Metal Texture" << std::endl;
-		m_pbrShader.setBool("haveMetalness", false);
+}
+
+void Renderer::loadSceneHdr(const std::string& filename)
+{
+	// ʱûоɵĻãִͬ決
+	beginEnvironmentBake(filename, true);
+	updateEnvironmentBake(std::numeric_limits<float>::max());
+}
+
+void Renderer::beginEnvironmentBake(const std::string& filename, bool blocking)
+{
+	// һλûɵĺ決ֱӶ
+	cancelEnvironmentBake();
+
+	std::string envFilePath = "./data/hdr/" + filename;
+	envFilePath += ".hdr";
+	const int envMapSize = m_EnvMapSize;
+
+	// ʾĻֱӴԴ滺ȡأļҲ決
+	if (std::shared_ptr<EnvironmentAssets> environment = m_gpuCache.find<EnvironmentAssets>(envFilePath)) {
+		m_environment = environment;
+		return;
 	}
 
-	try {
-		m_roughnessTexture = createTexture(
-			Image::fromFile(modelPath + "_roughness" + scene.texExt, 1),
-			GL_RED, GL_R8
-		);
-		m_pbrShader.setBool("haveRoughness", true);
+	m_envBake.active = true;
+	m_envBake.blocking = blocking;
+	m_envBake.name = filename;
+	m_envBake.path = envFilePath;
+	m_envBake.numUnits = 0;
+	m_envBake.doneUnits = 0;
+
+	// ڴ滺лк決ʱֻϴ
+	if (std::shared_ptr<BakedEnvironment> baked = m_cpuCache.find<BakedEnvironment>(envFilePath)) {
+		scheduleEnvironmentUpload(baked);
+		m_envBake.numUnits = int(m_envBake.units.size());
+		return;
 	}
-	catch (std::runtime_error) {
-		std::cout << "No Rough Texture" << std::endl;
-		m_pbrShader.setBool("haveRoughness", false);
+
+	// 㻺ҪȡHDRļ桢һŵ̨߳
+	m_envBake.source = ThreadPool::global().enqueue([envFilePath, envMapSize]() {
+		EnvironmentBake::Source source;
+		const std::shared_ptr<MappedFile> content = MappedFile::open(envFilePath);
+		source.key = EnvironmentCache::makeKey(content->data(), content->size(), envMapSize);
+		source.cached = EnvironmentCache::load(source.key);
+		if (!source.cached) {
+			// RGBEתΪRGB9E5ÿ4ֽڣCPUϳתΪcube mapmipmap
+			const std::shared_ptr<Image> equirect = HDRReader::decode(content->data(), content->size(), Image::Format::RGB9E5);
+			const std::shared_ptr<CubeMap> cube = IBLBaker::equirectToCube(equirect, envMapSize);
+			source.unfiltered = BakedEnvironment::fromCubeMap(*cube, IBLBaker::SHCoefficients());
+		}
+		return source;
+	});
+}
+
+void Renderer::updateEnvironmentBake(float budgetMs)
+{
+	collectBakeTimers();
+	if (!m_envBake.active) {
+		return;
 	}
 
-	try {
-		m_occlusionTexture = createTexture(
-			Image::fromFile(modelPath + "_occlusion" + scene.texExt, 1),
-			GL_RED, GL_R8
-		);
-		m_pbrShader.setBool("haveOcclusion", true);
+	const auto start = std::chrono::steady_clock::now();
+
+	// Ⱥ̶̨߳껺HDRɹԪ
+	if (m_envBake.source.valid()) {
+		if (!m_envBake.blocking && m_envBake.source.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+			return;
+		}
+		EnvironmentBake::Source source;
+		try {
+			source = m_envBake.source.get();
+		}
+		catch (const std::exception& e) {
+			if (m_envBake.blocking) {
+				throw;
+			}
+			// лʧʱǰ
+			std::cerr << "Failed to load environment " << m_envBake.name << ": " << e.what() << std::endl;
+			cancelEnvironmentBake();
+			return;
+		}
+
+		m_envBake.key = source.key;
+		if (source.cached) {
+			m_cpuCache.insert(m_envBake.path, source.cached, bakedEnvironmentBytes(*source.cached));
+			scheduleEnvironmentUpload(source.cached);
+		}
+		else {
+			scheduleEnvironmentBake(source.unfiltered);
+		}
+		m_envBake.numUnits = int(m_envBake.units.size());
 	}
-	catch (std::runtime_error) {
-		std::cout << "No Occlusion Texture" << std::endl;
-		m_pbrShader.setBool("haveOcclusion", false);
+
+	GLuint query;
+	glCreateQueries(GL_TIME_ELAPSED, 1, &query);
+	glBeginQuery(GL_TIME_ELAPSED, query);
+
+	double issuedCost = 0.0;
+	bool progressed = false;
+	while (!m_envBake.units.empty()) {
+		const BakeUnit& unit = m_envBake.units.front();
+		// CPUѾõʱ䣬ϱ֡ύGPUĹƺʱÿִ֡һԪ
+		const double elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		if (progressed && !m_envBake.blocking && elapsedMs + (issuedCost + unit.cost) * m_bakeMsPerCost > budgetMs) {
+			break;
+		}
+		if (!unit.run()) {
+			break;
+		}
+		issuedCost += unit.cost;
+		progressed = true;
+		m_envBake.units.pop_front();
+		++m_envBake.doneUnits;
 	}
 
-	try {
-		m_emissionTexture = createTexture(
-			Image::fromFile(modelPath + "_emission" + scene.texExt, 3),
-			GL_RGB, GL_SRGB8
-		);
-		m_pbrShader.setBool("haveEmission", true);
+	glEndQuery(GL_TIME_ELAPSED);
+	m_bakeTimers.push_back({ query, issuedCost });
+
+	if (m_envBake.units.empty()) {
+		m_envBake.active = false;
 	}
-	catch (std::runtime_error) {
-		std::cout << "No Emission Texture" << std::endl;
-		m_pbrShader.setBool("haveEmission", false);
-	} 
 }
 
-void Renderer::loadSceneHdr(const std::string& filename)
+void Renderer::scheduleEnvironmentUpload(const std::shared_ptr<BakedEnvironment>& cached)
 {
-	// δԤ˲ĻͼCube Map)
-	Texture envTextureUnfiltered = createTexture(GL_TEXTURE_CUBE_MAP, m_EnvMapSize, m_EnvMapSize, GL_RGBA16F);
+	// УϴBC6Hݣеļɫ
+	const GLenum internalformat = cached->isCompressed() ? GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT : GL_RGBA16F;
+	m_envBake.filtered = createTexture(GL_TEXTURE_CUBE_MAP, cached->size, cached->size, internalformat, cached->levels);
+	m_envBake.irradianceSH = cached->irradianceSH;
+	scheduleCubeMapUpload(m_envBake.filtered.id, cached);
+
+	// ȫϴ滻ǰĻͼ
+	const bool compressed = cached->isCompressed();
+	m_envBake.units.push_back({ 0.0, [this, compressed]() {
+		replaceEnvironment(compressed);
+		return true;
+	} });
+}
+
+void Renderer::scheduleEnvironmentBake(const std::shared_ptr<BakedEnvironment>& unfiltered)
+{
+	// δԤ˲ĻͼԼ˲ĻͼCube Map)
+	m_envBake.unfiltered = createTexture(GL_TEXTURE_CUBE_MAP, unfiltered->size, unfiltered->size, GL_RGBA16F, unfiltered->levels);
+	m_envBake.filtered = createTexture(GL_TEXTURE_CUBE_MAP, m_EnvMapSize, m_EnvMapSize, GL_RGBA16F);
+
+	// CPUѾתmipmapֿ龭PBOϴٰѵ0㣨ԭͼƵͼ
+	scheduleCubeMapUpload(m_envBake.unfiltered.id, unfiltered);
+	m_envBake.units.push_back({ 0.0, [this]() {
+		glCopyImageSubData(m_envBake.unfiltered.id, GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0,
+			m_envBake.filtered.id, GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0,
+			m_envBake.filtered.width, m_envBake.filtered.height, 6);
+		return true;
+	} });
 
-	std::string envFilePath = "./data/hdr/" + filename;
-	envFilePath += ".hdr";
-	Texture envTextureEquirect = createTexture(Image::fromFile(envFilePath, 3), GL_RGB, GL_RGB16F, 1);
-
-	// equirectangular ͶӰõĽд롰δԤ˲Ļͼ
-	m_equirectToCubeShader.use();
-	glBindTextureUnit(0, envTextureEquirect.id);
-	glBindImageTexture(1, envTextureUnfiltered.id, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-	m_equirectToCubeShader.compute(
-		envTextureUnfiltered.width / 32,
-		envTextureUnfiltered.height / 32,
-		6
-	);
-
-	// ѾͶӰenvTextureUnfilteredϣEquirectͼɾ
-	deleteTexture(envTextureEquirect);
-
-	// ΪδԤ˲ĻͼԶmipmap
-	glGenerateTextureMipmap(envTextureUnfiltered.id);
-
-	// ͼcube mapͣ
-	m_envTexture = createTexture(GL_TEXTURE_CUBE_MAP, m_EnvMapSize, m_EnvMapSize, GL_RGBA16F);
-	// ơδԤ˲Ļͼmipmap0㣨ԭͼͼĵ0
-	glCopyImageSubData(envTextureUnfiltered.id, GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0,
-		m_envTexture.id, GL_TEXTURE_CUBE_MAP, 0, 0, 0, 0,
-		m_envTexture.width, m_envTexture.height, 6);
-
-	// ˲ͼ
-	m_prefilterShader.use();
-	glBindTextureUnit(0, envTextureUnfiltered.id);
 	// ݴֲڶȲͬԻͼԤ˲ӵ1mipmapʼ0ԭͼ
-	const float maxMipmapLevels = glm::max(float(m_envTexture.levels - 1), 1.0f);
-	int size = m_EnvMapSize / 2;
-	for (int level = 1; level <= maxMipmapLevels; ++level) {
-		const GLuint numGroups = glm::max(1, size / 32);
-		// ָ㼶ͼ
-		glBindImageTexture(1, m_envTexture.id, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-		m_prefilterShader.setFloat("roughness", (float)level / maxMipmapLevels);
-		m_prefilterShader.compute(numGroups, numGroups, 6);
-		size /= 2;
-	}
-
-	// ˲ĻͼѾm_envTexture
-	// ɾԭеġδԤ˲Ļͼ
-	deleteTexture(envTextureUnfiltered);
-
-	// Ԥõ irradiance map.
-
-	m_irmapTexture = createTexture(GL_TEXTURE_CUBE_MAP, m_IrradianceMapSize, m_IrradianceMapSize, GL_RGBA16F, 1);
-
-	m_irradianceMapShader.use();
-	glBindTextureUnit(0, m_envTexture.id);
-	glBindImageTexture(1, m_irmapTexture.id, 0, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
-	m_irradianceMapShader.compute(
-		m_irmapTexture.width / 32,
-		m_irmapTexture.height / 32,
-		6
-	);
+	// ÿԪֻĳһĳBakeRowsPerUnit
+	for (int level = 1; level < m_envBake.filtered.levels; ++level) {
+		const int size = glm::max(m_EnvMapSize >> level, 1);
+		const PrefilterLevel samples = m_prefilterLevels[level];
+		for (int face = 0; face < 6; ++face) {
+			for (int row = 0; row < size; row += BakeRowsPerUnit) {
+				const double cost = double(size) * glm::min(BakeRowsPerUnit, size) * samples.numSamples;
+				m_envBake.units.push_back({ cost, [this, level, face, row, size, samples]() {
+					m_prefilterShader.use();
+					glBindTextureUnit(0, m_envBake.unfiltered.id);
+					glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_prefilterSamplesSSBO);
+					glBindImageTexture(1, m_envBake.filtered.id, level, GL_TRUE, 0, GL_WRITE_ONLY, GL_RGBA16F);
+					m_prefilterShader.setInt("firstSample", samples.firstSample);
+					m_prefilterShader.setInt("numSamples", samples.numSamples);
+					m_prefilterShader.setFloat("invWeight", samples.invWeight);
+					m_prefilterShader.setIVec3("invocationOffset", glm::ivec3(0, row, face));
+					m_prefilterShader.compute(glm::max(1, size / 32), 1, 1);
+					return true;
+				} });
+			}
+		}
+	}
+
+	// δԤ˲ĻͼͶӰõгϵϵ֮ǰҪGPUɣfence
+	const double shTexels = 6.0 * IBLBaker::SHProjectionSize * IBLBaker::SHProjectionSize;
+	m_envBake.units.push_back({ shTexels, [this]() {
+		projectIrradianceSH(m_envBake.unfiltered);
+		m_envBake.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		return true;
+	} });
+	m_envBake.units.push_back({ 0.0, [this]() {
+		if (!waitFence(m_envBake.fence, m_envBake.blocking)) {
+			return false;
+		}
+		glDeleteSync(m_envBake.fence);
+		m_envBake.fence = nullptr;
+		// ֻ144ֽڣCPUÿ֡ShadingUBһϴ
+		glGetNamedBufferSubData(m_shCoefficientsSSBO, 0, sizeof(m_envBake.irradianceSH), m_envBake.irradianceSH.data());
+		return true;
+	} });
+
+	// 滻ǰĻͼɾδԤ˲Ļͼ
+	// Ԥ˲imageStoreд룬֮պкPBRɫtexture()ҪTEXTURE_FETCH
+	m_envBake.units.push_back({ 0.0, [this]() {
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+		replaceEnvironment(false);
+		deleteTexture(m_envBake.unfiltered);
+		return true;
+	} });
+
+	// غ決д뻺棬´/лʱֱʹ
+	scheduleEnvironmentReadback();
+}
+
+void Renderer::scheduleEnvironmentReadback()
+{
+	const Texture texture = m_envBake.filtered;
+	std::shared_ptr<BakedEnvironment> environment = std::make_shared<BakedEnvironment>();
+	environment->size = texture.width;
+	environment->levels = texture.levels;
+	environment->levelPixels.resize(texture.levels);
+
+	// ÿһPBOύPBOfenceɿ֮fenceʱӳ俽ڴ棬̲߳õGPU
+	// ȡʱԪ֮ɾûPBOfence
+	struct ReadbackBand
+	{
+		GLuint buffer = 0;
+		GLsync fence = nullptr;
+		~ReadbackBand()
+		{
+			if (fence) {
+				glDeleteSync(fence);
+			}
+			if (buffer) {
+				glDeleteBuffers(1, &buffer);
+			}
+		}
+	};
+	std::vector<BakeUnit> copies, reads;
+	for (int level = 0; level < texture.levels; ++level) {
+		const int size = glm::max(texture.width >> level, 1);
+		const size_t faceSize = size_t(size) * size * 4;
+		const size_t pitch = size_t(size) * 4 * sizeof(uint16_t);
+		const int rowsPerBand = glm::max(1, int(UploadBandSize / pitch));
+		environment->levelPixels[level].resize(faceSize * 6);
+		for (int face = 0; face < 6; ++face) {
+			for (int y = 0; y < size; y += rowsPerBand) {
+				const int rows = glm::min(rowsPerBand, size - y);
+				const size_t bytes = pitch * rows;
+				char* pixels = reinterpret_cast<char*>(environment->levelPixels[level].data() + faceSize * face) + pitch * y;
+				const std::shared_ptr<ReadbackBand> band = std::make_shared<ReadbackBand>();
+				copies.push_back({ double(size) * rows, [texture, level, face, y, size, rows, bytes, band]() {
+					glCreateBuffers(1, &band->buffer);
+					glNamedBufferStorage(band->buffer, bytes, nullptr, GL_MAP_READ_BIT);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, band->buffer);
+					glGetTextureSubImage(texture.id, level, 0, y, face, size, rows, 1, GL_RGBA, GL_HALF_FLOAT, GLsizei(bytes), nullptr);
+					glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+					band->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+					return true;
+				} });
+				reads.push_back({ 0.0, [this, environment, pixels, bytes, band]() {
+					if (!waitFence(band->fence, m_envBake.blocking)) {
+						return false;
+					}
+					const void* mapped = glMapNamedBufferRange(band->buffer, 0, bytes, GL_MAP_READ_BIT);
+					std::memcpy(pixels, mapped, bytes);
+					glUnmapNamedBuffer(band->buffer);
+					glDeleteSync(band->fence);
+					glDeleteBuffers(1, &band->buffer);
+					band->fence = nullptr;
+					band->buffer = 0;
+					return true;
+				} });
+			}
+		}
+	}
+	// ȶȡǰReadbackBandsInFlightύ
+	for (size_t i = 0; i < copies.size() + ReadbackBandsInFlight; ++i) {
+		if (i < copies.size()) {
+			m_envBake.units.push_back(copies[i]);
+		}
+		if (i >= ReadbackBandsInFlight && i - ReadbackBandsInFlight < reads.size()) {
+			m_envBake.units.push_back(reads[i - ReadbackBandsInFlight]);
+		}
+	}
+
+	// ѹΪBC6HԼдļẉ̨̂߳ضĽͬʱڴ滺
+	m_envBake.units.push_back({ 0.0, [this, environment]() {
+		environment->irradianceSH = m_envBake.irradianceSH;
+		m_cpuCache.insert(m_envBake.path, environment, bakedEnvironmentBytes(*environment));
+		const EnvironmentCache::Key key = m_envBake.key;
+		ThreadPool::global().enqueue([key, environment]() {
+			try {
+				EnvironmentCache::store(key, *environment);
+			}
+			catch (const std::exception& e) {
+				std::cerr << "Failed to store IBL cache: " << e.what() << std::endl;
+			}
+		});
+		return true;
+	} });
+}
+
+void Renderer::replaceEnvironment(bool compressed)
+{
+	// µĻͼԴ滺棬ɵĻ̭Ҳʾʱɾ
+	std::shared_ptr<EnvironmentAssets> environment(new EnvironmentAssets(), [](EnvironmentAssets* assets) {
+		deleteTexture(assets->texture);
+		delete assets;
+	});
+	environment->texture = m_envBake.filtered;
+	environment->irradianceSH = m_envBake.irradianceSH;
+	environment->bytes = cubeMapBytes(m_envBake.filtered, compressed ? 1 : 8);
+	m_envBake.filtered = Texture();
+	m_environment = environment;
+	m_gpuCache.insert(m_envBake.path, environment, environment->bytes);
+}
+
+void Renderer::scheduleCubeMapUpload(GLuint texture, const std::shared_ptr<BakedEnvironment>& environment)
+{
+	for (int level = 0; level < environment->levels; ++level) {
+		const int size = glm::max(environment->size >> level, 1);
+		if (environment->isCompressed()) {
+			const size_t faceBytes = environment->compressedFaceBytes(level);
+			for (int face = 0; face < 6; ++face) {
+				const std::shared_ptr<const void> blocks(environment, environment->compressedLevels[level].data() + faceBytes * face);
+				scheduleCompressedUpload(texture, level, face, size, GL_COMPRESSED_RGB_BPTC_UNSIGNED_FLOAT, faceBytes / ((size + 3) / 4), blocks);
+			}
+			continue;
+		}
+
+		const size_t faceSize = size_t(size) * size * 4;
+		for (int face = 0; face < 6; ++face) {
+			// environmentüϴǰݲᱻͷ
+			const std::shared_ptr<const void> pixels(environment, environment->levelPixels[level].data() + faceSize * face);
+			scheduleTextureUpload(texture, GL_TEXTURE_CUBE_MAP, level, face, size, size,
+				GL_RGBA, GL_HALF_FLOAT, size * 4 * sizeof(uint16_t), pixels);
+		}
+	}
+}
+
+void Renderer::scheduleTextureUpload(GLuint texture, GLenum target, int level, int face, int width, int height,
+	GLenum format, GLenum type, size_t pitch, const std::shared_ptr<const void>& pixels)
+{
+	// гɲUploadBandSizeĿ飬ÿһԪ
+	const int rowsPerBand = glm::max(1, int(UploadBandSize / pitch));
+	for (int y = 0; y < height; y += rowsPerBand) {
+		const int rows = glm::min(rowsPerBand, height - y);
+		m_envBake.units.push_back({ 0.0, [=]() {
+			const void* src = static_cast<const char*>(pixels.get()) + pitch * y;
+			return uploadTextureRows(texture, target, level, face, y, width, rows, format, type, pitch, src, m_envBake.blocking);
+		} });
+	}
+}
+
+void Renderer::scheduleCompressedUpload(GLuint texture, int level, int face, int size, GLenum internalformat,
+	size_t blockRowBytes, const std::shared_ptr<const void>& blocks)
+{
+	// 4x4з֣һ߶ȶ4ı
+	const int blockRows = (size + 3) / 4;
+	const int rowsPerBand = glm::max(1, int(UploadBandSize / blockRowBytes));
+	for (int row = 0; row < blockRows; row += rowsPerBand) {
+		const int rows = glm::min(rowsPerBand, blockRows - row);
+		m_envBake.units.push_back({ 0.0, [=]() {
+			UploadRing::Allocation allocation;
+			if (!m_uploadRing.allocate(blockRowBytes * rows, allocation, m_envBake.blocking)) {
+				return false;
+			}
+			std::memcpy(allocation.pointer, static_cast<const char*>(blocks.get()) + blockRowBytes * row, blockRowBytes * rows);
+
+			const int y = row * 4;
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadRing.buffer());
+			glCompressedTextureSubImage3D(texture, level, 0, y, face, size, glm::min(rows * 4, size - y), 1, internalformat,
+				GLsizei(blockRowBytes * rows), reinterpret_cast<const void*>(allocation.offset));
+			glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+			return true;
+		} });
+	}
+}
+
+bool Renderer::uploadTextureRows(GLuint texture, GLenum target, int level, int face, int y, int width, int rows,
+	GLenum format, GLenum type, size_t pitch, const void* pixels, bool blocking)
+{
+	// ݴ滺GPUռʱfalseһ֡
+	UploadRing::Allocation allocation;
+	if (!m_uploadRing.allocate(pitch * rows, allocation, blocking)) {
+		return false;
+	}
+	std::memcpy(allocation.pointer, pixels, pitch * rows);
+
+	// PBOpixelsǻڵƫƣ첽
+	// ֮УRGB halfгȲһ4ı
+	const void* offset = reinterpret_cast<const void*>(allocation.offset);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_uploadRing.buffer());
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	if (target == GL_TEXTURE_CUBE_MAP) {
+		glTextureSubImage3D(texture, level, 0, y, face, width, rows, 1, format, type, offset);
+	}
+	else {
+		glTextureSubImage2D(texture, level, 0, y, width, rows, format, type, offset);
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return true;
+}
+
+void Renderer::cancelEnvironmentBake()
+{
+	// ̵̨߳޷жϣfutureɣٱʹ
+	m_envBake.source = std::future<EnvironmentBake::Source>();
+	m_envBake.units.clear();
+	deleteTexture(m_envBake.unfiltered);
+	deleteTexture(m_envBake.filtered);
+	if (m_envBake.fence) {
+		glDeleteSync(m_envBake.fence);
+		m_envBake.fence = nullptr;
+	}
+	m_envBake.active = false;
+}
+
+void Renderer::collectBakeTimers()
+{
+	// ʱͨһ֡ſãȴ
+	while (!m_bakeTimers.empty()) {
+		const BakeTimer timer = m_bakeTimers.front();
+		GLint available = 0;
+		glGetQueryObjectiv(timer.query, GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available) {
+			break;
+		}
+		GLuint64 elapsedNs = 0;
+		glGetQueryObjectui64v(timer.query, GL_QUERY_RESULT, &elapsedNs);
+		if (timer.cost >= BakeMinTimedCost) {
+			// ָƽƽβĶ
+			m_bakeMsPerCost = glm::mix(m_bakeMsPerCost, double(elapsedNs) * 1e-6 / timer.cost, 0.25);
+		}
+		glDeleteQueries(1, &timer.query);
+		m_bakeTimers.pop_front();
+	}
+}
+
+void Renderer::buildPrefilterSamples()
+{
+	// ֲֻڶԼͼĳߴйأʱCPUһΣ֮ÿлֱӸ
+	const int levels = Utility::numMipmapLevels(m_EnvMapSize, m_EnvMapSize);
+	std::vector<IBLBaker::PrefilterSample> samples;
+	m_prefilterLevels.assign(levels, PrefilterLevel{ 0, 0, 0.0f });
+	for (int level = 1; level < levels; ++level) {
+		const IBLBaker::PrefilterSampleTable table = IBLBaker::buildPrefilterSamples(
+			IBLBaker::prefilterRoughness(level, levels), IBLBaker::PrefilterSamples, m_EnvMapSize, levels);
+		m_prefilterLevels[level] = { int(samples.size()), int(table.samples.size()), table.invWeight };
+		samples.insert(samples.end(), table.samples.begin(), table.samples.end());
+	}
+	m_prefilterSamplesSSBO = createStorageBuffer(samples.size() * sizeof(IBLBaker::PrefilterSample), samples.data());
+}
+
+void Renderer::projectIrradianceSH(const Texture& envTextureUnfiltered)
+{
+	// ֻҪƵϢҵߴ粻SHProjectionSizeһmipmap
+	int level = 0;
+	while ((envTextureUnfiltered.width >> level) > IBLBaker::SHProjectionSize && level + 1 < envTextureUnfiltered.levels) {
+		++level;
+	}
+	const int size = glm::max(envTextureUnfiltered.width >> level, 1);
+	const GLuint numGroups = glm::max(1, size / 16);
+
+	// ÿwork groupԼһݲֺ
+	m_shProjectShader.use();
+	glBindImageTexture(0, envTextureUnfiltered.id, level, GL_TRUE, 0, GL_READ_ONLY, GL_RGBA16F);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 0, m_shPartialSumsSSBO);
+	m_shProjectShader.compute(numGroups, numGroups, 6);
+	glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+
+	// ܵõ9ϵ
+	m_shReduceShader.use();
+	m_shReduceShader.setInt("numGroups", numGroups * numGroups * 6);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, m_shCoefficientsSSBO);
+	m_shReduceShader.compute(1, 1, 1);
+	// ϵɵfence֮
+	glMemoryBarrier(GL_BUFFER_UPDATE_BARRIER_BIT | GL_TEXTURE_UPDATE_BARRIER_BIT);
 }
  
+
 void Renderer::calcLUT() 
 {
-	// Ԥ߹ⲿҪLook Up Texture (cosTheta, roughness)
-	ComputeShader LUTShader = ComputeShader("data/shaders/cs_lut.glsl");
-
-	m_BRDF_LUT = createTexture(GL_TEXTURE_2D, m_BRDF_LUT_Size, m_BRDF_LUT_Size, GL_RG16F, 1);
+	// split-sumBRDF LUTLUTGen߻ֺֻϴ
+	m_BRDF_LUT = createTexture(GL_TEXTURE_2D, BRDFLUT::Size, BRDFLUT::Size, GL_RG16F, 1);
 	glTextureParameteri(m_BRDF_LUT.id, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTextureParameteri(m_BRDF_LUT.id, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-	LUTShader.use();
-	glBindImageTexture(0, m_BRDF_LUT.id, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_RG16F);
-	LUTShader.compute(
-		m_BRDF_LUT.width / 32,
-		m_BRDF_LUT.height / 32,
-		1
-	);
-	LUTShader.deleteProgram();
+	glTextureSubImage2D(m_BRDF_LUT.id, 0, 0, 0, BRDFLUT::Size, BRDFLUT::Size, GL_RG, GL_HALF_FLOAT, BRDFLUT::embedded());
 }
 
 #if _DEBUG
@@ -1,20 +1,42 @@
 #pragma once
 
 #include <glad/glad.h>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
 #include <glm/mat4x4.hpp>
 
 #include "shader.hpp"
 #include "camera.hpp"
 #include "scene_setting.hpp"
+#include "baker.hpp"
+#include "env_cache.hpp"
+#include "upload_ring.hpp"
+#include "asset_cache.hpp"
 
 struct GLFWwindow;
 
 struct MeshBuffer
 {
-	MeshBuffer() : vbo(0), ibo(0), vao(0) {}
+	MeshBuffer() : vbo(0), ibo(0), vao(0), indirect(0), drawCount(0), indexType(GL_UNSIGNED_INT), packed(false), boundsMin(0.0f), boundsExtent(1.0f),
+		numLods(1), lodErrors(), boundingSphere(0.0f) {}
 	GLuint vbo, ibo, vao;
 	GLuint numElements;
+	// ÿһDrawElementsIndirectCommandһglMultiDrawElementsIndirect
+	// LODδţÿdrawCount
+	GLuint indirect;
+	GLsizei drawCount;
+	GLenum indexType;
+	// ѹʽMesh::PackedVertexλɫΧлԭ
+	bool packed;
+	glm::vec3 boundsMin, boundsExtent;
+	// ĻϵͶӰѡLODMesh::lodError
+	int numLods;
+	float lodErrors[Mesh::MaxLods];
+	glm::vec4 boundingSphere;
 };
 
 struct FrameBuffer
@@ -35,6 +57,55 @@ struct Texture
 	int levels;
 };
 
+// һģϴGPUȫԴԴ滺͵ǰʾģ͹ͬ
+struct ModelAssets
+{
+	Mesh::ObjectType type;
+	float scale;
+	MeshBuffer mesh;
+	// һ֡ʹõLODлʱͺ
+	int lod;
+	Texture albedo;
+	Texture normal;
+	// RAOGֲڶȣB
+	Texture orm;
+	Texture emission;
+	size_t bytes;
+};
+
+// ̨̼߳ͼĽԤȴ򻺴棩ʱΪڴӳΪδѹmipmap
+// ߶԰㼶ϴ
+struct TextureSource
+{
+	std::shared_ptr<class TextureFile> file;
+	std::vector<std::shared_ptr<class Image>> mipChain;
+
+	int width() const;
+	int height() const;
+	int levels() const;
+};
+
+// ģCPUϵԴݣڴ滺Դ滺̭Բļϴ
+struct ModelSource
+{
+	// ʡߡԷ⡢ORM
+	static const int NumTextures = 4;
+
+	Mesh::ObjectType type;
+	float scale;
+	std::shared_ptr<class Mesh> mesh;
+	// ̳߳ϼأģͲͼͿʾȱʧĿѡͼΪЧfuture
+	std::shared_future<TextureSource> textures[NumTextures];
+};
+
+// Ԥ˲ĻͼԼõгϵ
+struct EnvironmentAssets
+{
+	Texture texture;
+	IBLBaker::SHCoefficients irradianceSH;
+	size_t bytes;
+};
+
 class Renderer
 {
 public:
@@ -47,20 +118,44 @@ public:
 
 private:
 	Texture createTexture(GLenum target, int width, int height, GLenum internalformat, int levels = 0) const;
-	Texture createTexture(const std::shared_ptr<class Image>& image, GLenum format, GLenum internalformat, int levels = 0) const;
+	// sourceͼϴݣԴʽmipmapʹinternalformat
+	Texture createTexture(const TextureSource& source, GLenum internalformat) const;
+	// ϴһ㼶ϴֽ
+	static size_t uploadTextureLevel(const Texture& texture, const TextureSource& source, int level, GLenum format);
 	static void deleteTexture(Texture& texture);
 
 	static FrameBuffer createFrameBuffer(int width, int height, int samples, GLenum colorFormat, GLenum depthstencilFormat);
 	static void resolveFramebuffer(const FrameBuffer& srcfb, const FrameBuffer& dstfb);
 	static void deleteFrameBuffer(FrameBuffer& fb);
 
-	static MeshBuffer createMeshBuffer(const std::shared_ptr<class Mesh>& mesh);
+	// ϲһ㻺УpackedʱʹѹʽÿĶ65536ʱҲ16λ
+	static MeshBuffer createMeshBuffer(const std::shared_ptr<class Mesh>& mesh, bool packed = false);
 	static void deleteMeshBuffer(MeshBuffer& buffer);
+	static void drawMeshBuffer(const MeshBuffer& buffer, int lod = 0);
 
 	static GLuint createUniformBuffer(const void* data, size_t size);
+	static GLuint createStorageBuffer(size_t size, const void* data = nullptr);
 
 	void loadModels(const std::string& modelName, SceneSettings& scene);
+	void updateTextureStreaming();
 	void loadSceneHdr(const std::string& filename);
+	void beginEnvironmentBake(const std::string& filename, bool blocking);
+	void updateEnvironmentBake(float budgetMs);
+	void scheduleEnvironmentUpload(const std::shared_ptr<BakedEnvironment>& cached);
+	void scheduleEnvironmentBake(const std::shared_ptr<BakedEnvironment>& unfiltered);
+	void scheduleCubeMapUpload(GLuint texture, const std::shared_ptr<BakedEnvironment>& environment);
+	void scheduleEnvironmentReadback();
+	void replaceEnvironment(bool compressed);
+	void scheduleTextureUpload(GLuint texture, GLenum target, int level, int face, int width, int height,
+		GLenum format, GLenum type, size_t pitch, const std::shared_ptr<const void>& pixels);
+	void scheduleCompressedUpload(GLuint texture, int level, int face, int size, GLenum internalformat,
+		size_t blockRowBytes, const std::shared_ptr<const void>& blocks);
+	bool uploadTextureRows(GLuint texture, GLenum target, int level, int face, int y, int width, int rows,
+		GLenum format, GLenum type, size_t pitch, const void* pixels, bool blocking);
+	void cancelEnvironmentBake();
+	void collectBakeTimers();
+	void buildPrefilterSamples();
+	void projectIrradianceSH(const Texture& envTextureUnfiltered);
 	void calcLUT();
 	
 
@@ -81,34 +176,101 @@ private:
 	FrameBuffer m_resolveFramebuffer;
 
 	MeshBuffer m_skybox;
-	MeshBuffer m_pbrModel;
 
 	GLuint m_emptyVAO;
 
 	Shader m_tonemapShader;
 	Shader m_skyboxShader;
 	Shader m_pbrShader;
-	ComputeShader m_equirectToCubeShader;
 	ComputeShader m_prefilterShader;
-	ComputeShader m_irradianceMapShader;
+	ComputeShader m_shProjectShader;
+	ComputeShader m_shReduceShader;
 
 	int m_EnvMapSize;
-	int m_IrradianceMapSize;
-	int m_BRDF_LUT_Size;
 
-	Texture m_envTexture;
-	Texture m_irmapTexture;
 	Texture m_BRDF_LUT;
 
-	Texture m_albedoTexture;
-	Texture m_normalTexture;
-	Texture m_metalnessTexture;
-	Texture m_roughnessTexture;
-	Texture m_occlusionTexture;
-	Texture m_emissionTexture;
+	// ǰʾģͺͻлɵԴڻ̭Ҳʹʱɾ
+	std::shared_ptr<ModelAssets> m_model;
+	std::shared_ptr<EnvironmentAssets> m_environment;
+	// ·Դ滺棨ģͼͼڴ滺棨ģ͵Դݡ決õĻԤ
+	AssetCache m_gpuCache;
+	AssetCache m_cpuCache;
 
 	GLuint m_transformUB;
 	GLuint m_shadingUB;
+
+	// mipmap㼶Ԥ˲һSSBO
+	struct PrefilterLevel
+	{
+		int firstSample;
+		int numSamples;
+		float invWeight;
+	};
+	GLuint m_prefilterSamplesSSBO;
+	std::vector<PrefilterLevel> m_prefilterLevels;
+
+	GLuint m_shPartialSumsSSBO;
+	GLuint m_shCoefficientsSSBO;
+
+	// ʽ決лʱѶȡͶӰԤ˲гضСĹԪ
+	// ÿ֡Ԥʱִһ֣֮ǰʹþɵĻͼ
+	struct BakeUnit
+	{
+		double cost;				// ƵGPUز
+		std::function<bool()> run;	// falseʾҪȴfenceδɣһ֡
+	};
+	struct EnvironmentBake
+	{
+		// ̵̨߳ĽʱΪcachedΪCPUתõcube maphalfmipmapгϵ
+		struct Source
+		{
+			EnvironmentCache::Key key;
+			std::shared_ptr<BakedEnvironment> cached;
+			std::shared_ptr<BakedEnvironment> unfiltered;
+		};
+
+		bool active = false;
+		bool blocking = false;
+		std::string name;
+		std::string path;
+		std::future<Source> source;
+		EnvironmentCache::Key key;
+
+		std::deque<BakeUnit> units;
+		int numUnits = 0;
+		int doneUnits = 0;
+
+		Texture unfiltered;
+		Texture filtered;
+		IBLBaker::SHCoefficients irradianceSH;
+		std::shared_ptr<BakedEnvironment> readback;
+		GLsync fence = nullptr;
+	} m_envBake;
+
+	// GPUʱѯѹɺ
+	struct BakeTimer
+	{
+		GLuint query;
+		double cost;
+	};
+	std::deque<BakeTimer> m_bakeTimers;
+	double m_bakeMsPerCost;
+
+	// ɴֵϸͼʽأͼĲ䣬СĲ㼶ʼÿ֡ϴһ֣
+	// ͬʱbase levelģģͼʾ𽥱
+	struct TextureStream
+	{
+		std::string key;						// ģڻеļ
+		std::weak_ptr<ModelAssets> model;		// ģͱɾ
+		std::shared_ptr<ModelSource> source;
+		int slot;
+		int nextLevel;							// һҪϴĲ㼶-1ʾͼûз
+	};
+	std::vector<TextureStream> m_textureStreams;
+
+	// ϴõĳ־ӳPBO
+	UploadRing m_uploadRing;
 };
 
 
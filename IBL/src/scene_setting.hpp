@@ -29,4 +29,14 @@ public:
 	float objectScale;
 	float objectYaw;
 	float objectPitch;
+
+	// ÿ֡ڻ決ʱԤ㣨룩
+	float envBakeBudget;
+
+	// ģʹѹʽMesh::PackedVertex
+	bool packedVertices;
+
+	// ģͺͻлʱԴ桢ڴ滺Ԥ㣨MB
+	float gpuCacheBudget;
+	float cpuCacheBudget;
 };
@@ -0,0 +1,390 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+
+// 8SIMDװx64¿AVX2/arch:AVX2Win32˻Ϊͨѭ
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SIMD_AVX2 1
+#else
+#define SIMD_AVX2 0
+#endif
+
+namespace simd
+{
+	const int Width = 8;
+
+#if SIMD_AVX2
+
+	struct float8
+	{
+		__m256 v;
+		float8() {}
+		float8(__m256 x) : v(x) {}
+		float8(float s) : v(_mm256_set1_ps(s)) {}
+
+		static float8 load(const float* p) { return _mm256_loadu_ps(p); }
+		void store(float* p) const { _mm256_storeu_ps(p, v); }
+		float operator[](int i) const { alignas(32) float tmp[8]; _mm256_store_ps(tmp, v); return tmp[i]; }
+	};
+
+	struct int8
+	{
+		__m256i v;
+		int8() {}
+		int8(__m256i x) : v(x) {}
+		int8(int s) : v(_mm256_set1_epi32(s)) {}
+
+		static int8 load(const int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+		// ȡ8޷ֽڲչ
+		static int8 loadBytes(const uint8_t* p) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p))); }
+		void store(int32_t* p) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+	};
+
+	inline float8 operator+(const float8& a, const float8& b) { return _mm256_add_ps(a.v, b.v); }
+	inline float8 operator-(const float8& a, const float8& b) { return _mm256_sub_ps(a.v, b.v); }
+	inline float8 operator*(const float8& a, const float8& b) { return _mm256_mul_ps(a.v, b.v); }
+	inline float8 operator/(const float8& a, const float8& b) { return _mm256_div_ps(a.v, b.v); }
+	inline float8 operator-(const float8& a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); }
+	// a * b + c
+	inline float8 fmadd(const float8& a, const float8& b, const float8& c) { return _mm256_fmadd_ps(a.v, b.v, c.v); }
+	inline float8 min(const float8& a, const float8& b) { return _mm256_min_ps(a.v, b.v); }
+	inline float8 max(const float8& a, const float8& b) { return _mm256_max_ps(a.v, b.v); }
+	inline float8 abs(const float8& a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); }
+	inline float8 sqrt(const float8& a) { return _mm256_sqrt_ps(a.v); }
+	inline float8 floor(const float8& a) { return _mm256_floor_ps(a.v); }
+
+	// ȽϽΪȫ1/ȫ0
+	inline float8 operator>(const float8& a, const float8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); }
+	inline float8 operator>=(const float8& a, const float8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); }
+	inline float8 operator<(const float8& a, const float8& b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); }
+	inline float8 operator&(const float8& a, const float8& b) { return _mm256_and_ps(a.v, b.v); }
+	inline float8 operator|(const float8& a, const float8& b) { return _mm256_or_ps(a.v, b.v); }
+	// mask ? a : b
+	inline float8 select(const float8& mask, const float8& a, const float8& b) { return _mm256_blendv_ps(b.v, a.v, mask.v); }
+
+	inline int8 operator+(const int8& a, const int8& b) { return _mm256_add_epi32(a.v, b.v); }
+	inline int8 operator-(const int8& a, const int8& b) { return _mm256_sub_epi32(a.v, b.v); }
+	inline int8 operator*(const int8& a, const int8& b) { return _mm256_mullo_epi32(a.v, b.v); }
+	inline int8 min(const int8& a, const int8& b) { return _mm256_min_epi32(a.v, b.v); }
+	inline int8 max(const int8& a, const int8& b) { return _mm256_max_epi32(a.v, b.v); }
+	inline int8 operator&(const int8& a, const int8& b) { return _mm256_and_si256(a.v, b.v); }
+	inline int8 operator|(const int8& a, const int8& b) { return _mm256_or_si256(a.v, b.v); }
+	// ߼λ
+	inline int8 operator<<(const int8& a, int n) { return _mm256_slli_epi32(a.v, n); }
+	inline int8 operator>>(const int8& a, int n) { return _mm256_srli_epi32(a.v, n); }
+	inline int8 select(const float8& mask, const int8& a, const int8& b)
+	{
+		return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b.v), _mm256_castsi256_ps(a.v), mask.v));
+	}
+
+	// ȡ
+	inline int8 toInt(const float8& a) { return _mm256_cvttps_epi32(a.v); }
+	inline float8 toFloat(const int8& a) { return _mm256_cvtepi32_ps(a.v); }
+	// λ½Ϊfloat
+	inline float8 asFloat(const int8& a) { return _mm256_castsi256_ps(a.v); }
+	inline int8 asInt(const float8& a) { return _mm256_castps_si256(a.v); }
+
+	// base[index[i]]
+	inline float8 gather(const float* base, const int8& index) { return _mm256_i32gather_ps(base, index.v, 4); }
+	inline int8 gather(const int32_t* base, const int8& index) { return _mm256_i32gather_epi32(reinterpret_cast<const int*>(base), index.v, 4); }
+
+	inline float reduceAdd(const float8& a)
+	{
+		__m128 lo = _mm_add_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+		lo = _mm_hadd_ps(lo, lo);
+		lo = _mm_hadd_ps(lo, lo);
+		return _mm_cvtss_f32(lo);
+	}
+
+#else
+
+	struct float8
+	{
+		float v[8];
+		float8() {}
+		float8(float s) { for (int i = 0; i < 8; ++i) v[i] = s; }
+
+		static float8 load(const float* p) { float8 r; for (int i = 0; i < 8; ++i) r.v[i] = p[i]; return r; }
+		void store(float* p) const { for (int i = 0; i < 8; ++i) p[i] = v[i]; }
+		float operator[](int i) const { return v[i]; }
+	};
+
+	struct int8
+	{
+		int32_t v[8];
+		int8() {}
+		int8(int s) { for (int i = 0; i < 8; ++i) v[i] = s; }
+
+		static int8 load(const int32_t* p) { int8 r; for (int i = 0; i < 8; ++i) r.v[i] = p[i]; return r; }
+		static int8 loadBytes(const uint8_t* p) { int8 r; for (int i = 0; i < 8; ++i) r.v[i] = p[i]; return r; }
+		void store(int32_t* p) const { for (int i = 0; i < 8; ++i) p[i] = v[i]; }
+	};
+
+#define SIMD_SCALAR_OP(T, expr) { T r; for (int i = 0; i < 8; ++i) r.v[i] = (expr); return r; }
+#define SIMD_MASK(cond) ((cond) ? maskTrue() : 0.0f)
+
+	inline float maskTrue() { uint32_t bits = 0xFFFFFFFFu; float f; std::memcpy(&f, &bits, 4); return f; }
+	inline bool maskSet(float f) { uint32_t bits; std::memcpy(&bits, &f, 4); return bits != 0; }
+
+	inline float8 operator+(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, a.v[i] + b.v[i])
+	inline float8 operator-(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, a.v[i] - b.v[i])
+	inline float8 operator*(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, a.v[i] * b.v[i])
+	inline float8 operator/(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, a.v[i] / b.v[i])
+	inline float8 operator-(const float8& a) SIMD_SCALAR_OP(float8, -a.v[i])
+	inline float8 fmadd(const float8& a, const float8& b, const float8& c) SIMD_SCALAR_OP(float8, a.v[i] * b.v[i] + c.v[i])
+	// minps/maxpsһ£NaNʱصڶ
+	inline float8 min(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, a.v[i] < b.v[i] ? a.v[i] : b.v[i])
+	inline float8 max(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, a.v[i] > b.v[i] ? a.v[i] : b.v[i])
+	inline float8 abs(const float8& a) SIMD_SCALAR_OP(float8, std::fabs(a.v[i]))
+	inline float8 sqrt(const float8& a) SIMD_SCALAR_OP(float8, std::sqrt(a.v[i]))
+	inline float8 floor(const float8& a) SIMD_SCALAR_OP(float8, std::floor(a.v[i]))
+
+	inline float8 operator>(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, SIMD_MASK(a.v[i] > b.v[i]))
+	inline float8 operator>=(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, SIMD_MASK(a.v[i] >= b.v[i]))
+	inline float8 operator<(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, SIMD_MASK(a.v[i] < b.v[i]))
+	inline float8 operator&(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, SIMD_MASK(maskSet(a.v[i]) && maskSet(b.v[i])))
+	inline float8 operator|(const float8& a, const float8& b) SIMD_SCALAR_OP(float8, SIMD_MASK(maskSet(a.v[i]) || maskSet(b.v[i])))
+	inline float8 select(const float8& mask, const float8& a, const float8& b) SIMD_SCALAR_OP(float8, maskSet(mask.v[i]) ? a.v[i] : b.v[i])
+
+	inline int8 operator+(const int8& a, const int8& b) SIMD_SCALAR_OP(int8, a.v[i] + b.v[i])
+	inline int8 operator-(const int8& a, const int8& b) SIMD_SCALAR_OP(int8, a.v[i] - b.v[i])
+	inline int8 operator*(const int8& a, const int8& b) SIMD_SCALAR_OP(int8, a.v[i] * b.v[i])
+	inline int8 min(const int8& a, const int8& b) SIMD_SCALAR_OP(int8, std::min(a.v[i], b.v[i]))
+	inline int8 max(const int8& a, const int8& b) SIMD_SCALAR_OP(int8, std::max(a.v[i], b.v[i]))
+	inline int8 operator&(const int8& a, const int8& b) SIMD_SCALAR_OP(int8, a.v[i] & b.v[i])
+	inline int8 operator|(const int8& a, const int8& b) SIMD_SCALAR_OP(int8, a.v[i] | b.v[i])
+	inline int8 operator<<(const int8& a, int n) SIMD_SCALAR_OP(int8, int32_t(uint32_t(a.v[i]) << n))
+	inline int8 operator>>(const int8& a, int n) SIMD_SCALAR_OP(int8, int32_t(uint32_t(a.v[i]) >> n))
+	inline int8 select(const float8& mask, const int8& a, const int8& b) SIMD_SCALAR_OP(int8, maskSet(mask.v[i]) ? a.v[i] : b.v[i])
+
+	inline int8 toInt(const float8& a) SIMD_SCALAR_OP(int8, static_cast<int32_t>(a.v[i]))
+	inline float8 toFloat(const int8& a) SIMD_SCALAR_OP(float8, static_cast<float>(a.v[i]))
+	inline float8 asFloat(const int8& a)
+	{
+		float8 r;
+		std::memcpy(r.v, a.v, sizeof(r.v));
+		return r;
+	}
+	inline int8 asInt(const float8& a)
+	{
+		int8 r;
+		std::memcpy(r.v, a.v, sizeof(r.v));
+		return r;
+	}
+
+	inline float8 gather(const float* base, const int8& index) SIMD_SCALAR_OP(float8, base[index.v[i]])
+	inline int8 gather(const int32_t* base, const int8& index) SIMD_SCALAR_OP(int8, base[index.v[i]])
+
+	inline float reduceAdd(const float8& a)
+	{
+		float sum = 0.0f;
+		for (int i = 0; i < 8; ++i) sum += a.v[i];
+		return sum;
+	}
+
+#undef SIMD_MASK
+#undef SIMD_SCALAR_OP
+
+#endif
+
+	// 0,1,...,7
+	inline float8 laneIndex()
+	{
+		static const float lanes[8] = { 0, 1, 2, 3, 4, 5, 6, 7 };
+		return float8::load(lanes);
+	}
+
+	// ʽƵatan2Լ2e-6ȣxyΪ0ʱ0
+	inline float8 atan2(const float8& y, const float8& x)
+	{
+		const float8 ax = abs(x), ay = abs(y);
+		const float8 a = min(ax, ay) / max(max(ax, ay), float8(1e-30f));
+		const float8 s = a * a;
+		float8 r = fmadd(float8(-0.01172120f), s, float8(0.05265332f));
+		r = fmadd(r, s, float8(-0.11643287f));
+		r = fmadd(r, s, float8(0.19354346f));
+		r = fmadd(r, s, float8(-0.33262347f));
+		r = fmadd(r, s, float8(0.99997726f)) * a;
+		r = select(ay > ax, float8(1.57079633f) - r, r);
+		r = select(x < float8(0.0f), float8(3.14159265f) - r, r);
+		return select(y < float8(0.0f), -r, r);
+	}
+
+	// Abramowitz & Stegun 4.4.46|x| <= 1ʱfloat
+	inline float8 acos(const float8& x)
+	{
+		const float8 ax = min(abs(x), float8(1.0f));
+		float8 p = fmadd(float8(-0.0012624911f), ax, float8(0.0066700901f));
+		p = fmadd(p, ax, float8(-0.0170881256f));
+		p = fmadd(p, ax, float8(0.0308918810f));
+		p = fmadd(p, ax, float8(-0.0501743046f));
+		p = fmadd(p, ax, float8(0.0889789874f));
+		p = fmadd(p, ax, float8(-0.2145988016f));
+		p = fmadd(p, ax, float8(1.5707963050f));
+		const float8 r = sqrt(float8(1.0f) - ax) * p;
+		return select(x < float8(0.0f), float8(3.14159265f) - r, r);
+	}
+
+	inline uint32_t asUint(float f) { uint32_t u; std::memcpy(&u, &f, 4); return u; }
+	inline float asFloat(uint32_t u) { float f; std::memcpy(&f, &u, 4); return f; }
+
+	// float -> halfͽ뵽żΧֵΪinf
+	inline uint16_t floatToHalf(float value)
+	{
+		uint32_t x = asUint(value);
+		const uint32_t sign = x & 0x80000000u;
+		x ^= sign;
+
+		uint16_t result;
+		if (x >= 0x47800000u) {
+			result = (x > 0x7F800000u) ? 0x7E00 : 0x7C00;
+		}
+		else if (x < 0x38800000u) {
+			// ǹӷ10λβ뵽λ
+			const float f = asFloat(x) + asFloat(126u << 23);
+			result = uint16_t(asUint(f) - (126u << 23));
+		}
+		else {
+			const uint32_t mantissaOdd = (x >> 13) & 1u;
+			x += 0xC8000FFFu + mantissaOdd;
+			result = uint16_t(x >> 13);
+		}
+		return uint16_t(result | (sign >> 16));
+	}
+
+	inline float halfToFloat(uint16_t value)
+	{
+		const uint32_t shiftedExponent = 0x7C00u << 13;
+		uint32_t x = uint32_t(value & 0x7FFFu) << 13;
+		const uint32_t exponent = shiftedExponent & x;
+		x += (127u - 15u) << 23;
+		if (exponent == shiftedExponent) {
+			x += (128u - 16u) << 23;
+		}
+		else if (exponent == 0) {
+			x += 1u << 23;
+			x = asUint(asFloat(x) - asFloat(113u << 23));
+		}
+		return asFloat(x | (uint32_t(value & 0x8000u) << 16));
+	}
+
+	// 8floatתΪhalfдdst
+	inline void storeHalf(const float8& a, uint16_t* dst)
+	{
+#if SIMD_AVX2
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm256_cvtps_ph(a.v, _MM_FROUND_TO_NEAREST_INT));
+#else
+		for (int i = 0; i < Width; ++i) {
+			dst[i] = floatToHalf(a.v[i]);
+		}
+#endif
+	}
+
+	// תAVX2ʹF16Cָ
+	inline void floatToHalf(const float* src, uint16_t* dst, size_t count)
+	{
+		size_t i = 0;
+#if SIMD_AVX2
+		for (; i + Width <= count; i += Width) {
+			const __m128i half = _mm256_cvtps_ph(_mm256_loadu_ps(src + i), _MM_FROUND_TO_NEAREST_INT);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), half);
+		}
+#endif
+		for (; i < count; ++i) {
+			dst[i] = floatToHalf(src[i]);
+		}
+	}
+
+	inline void halfToFloat(const uint16_t* src, float* dst, size_t count)
+	{
+		size_t i = 0;
+#if SIMD_AVX2
+		for (; i + Width <= count; i += Width) {
+			const __m128i half = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			_mm256_storeu_ps(dst + i, _mm256_cvtph_ps(half));
+		}
+#endif
+		for (; i < count; ++i) {
+			dst[i] = halfToFloat(src[i]);
+		}
+	}
+
+	// RGB9E5EXT_texture_shared_exponent9λβһ5λָƫ15
+	// NaNΪ065408ֵض
+	inline int8 packRGB9E5(const float8& r, const float8& g, const float8& b)
+	{
+		const float8 zero(0.0f), maxValue(65408.0f);
+		const float8 rc = min(max(r, zero), maxValue);
+		const float8 gc = min(max(g, zero), maxValue);
+		const float8 bc = min(max(b, zero), maxValue);
+		const float8 maxc = max(max(rc, gc), bc);
+
+		// floor(log2(maxc))ֱȡָλС2^-16ʱ-16
+		int8 exponent = max((asInt(maxc) >> 23) - int8(127), int8(-16)) + int8(16);
+		// 2^(24 - exponent)2Ǿȷ
+		float8 scale = asFloat((int8(24 + 127) - exponent) << 23);
+		// λ512ʱָһ
+		const float8 carry = fmadd(maxc, scale, float8(0.5f)) >= float8(512.0f);
+		exponent = select(carry, exponent + int8(1), exponent);
+		scale = select(carry, scale * float8(0.5f), scale);
+
+		const int8 rs = toInt(fmadd(rc, scale, float8(0.5f)));
+		const int8 gs = toInt(fmadd(gc, scale, float8(0.5f)));
+		const int8 bs = toInt(fmadd(bc, scale, float8(0.5f)));
+		return rs | (gs << 9) | (bs << 18) | (exponent << 27);
+	}
+
+	inline void unpackRGB9E5(const int8& packed, float8 rgb[3])
+	{
+		// 2^(exponent - 24)
+		const float8 scale = asFloat(((packed >> 27) + int8(127 - 24)) << 23);
+		const int8 mask(0x1FF);
+		rgb[0] = toFloat(packed & mask) * scale;
+		rgb[1] = toFloat((packed >> 9) & mask) * scale;
+		rgb[2] = toFloat((packed >> 18) & mask) * scale;
+	}
+
+	// תsrcÿstridefloatֻʹǰ
+	inline void floatToRGB9E5(const float* src, int stride, uint32_t* dst, size_t count)
+	{
+		float rgb[3][Width];
+		int32_t packed[Width];
+		for (size_t i = 0; i < count; i += Width) {
+			const int n = int(std::min<size_t>(Width, count - i));
+			for (int lane = 0; lane < Width; ++lane) {
+				const float* p = src + (i + std::min(lane, n - 1)) * stride;
+				rgb[0][lane] = p[0];
+				rgb[1][lane] = p[1];
+				rgb[2][lane] = p[2];
+			}
+			packRGB9E5(float8::load(rgb[0]), float8::load(rgb[1]), float8::load(rgb[2])).store(packed);
+			std::memcpy(dst + i, packed, n * sizeof(uint32_t));
+		}
+	}
+
+	// dstÿstridefloatֻдǰ
+	inline void rgb9e5ToFloat(const uint32_t* src, float* dst, int stride, size_t count)
+	{
+		int32_t packed[Width] = {};
+		float rgb[3][Width];
+		for (size_t i = 0; i < count; i += Width) {
+			const int n = int(std::min<size_t>(Width, count - i));
+			std::memcpy(packed, src + i, n * sizeof(uint32_t));
+			float8 value[3];
+			unpackRGB9E5(int8::load(packed), value);
+			for (int c = 0; c < 3; ++c) {
+				value[c].store(rgb[c]);
+			}
+			for (int lane = 0; lane < n; ++lane) {
+				float* p = dst + (i + lane) * stride;
+				p[0] = rgb[0][lane];
+				p[1] = rgb[1][lane];
+				p[2] = rgb[2][lane];
+			}
+		}
+	}
+}
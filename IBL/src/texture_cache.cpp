@@ -0,0 +1,66 @@
+#include <cinttypes>
+#include <cstdio>
+#include <iostream>
+
+#include "texture_cache.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	const uint32_t CacheVersion = 3;
+}
+
+const char* TextureCache::Directory = "./data/cache";
+
+uint64_t TextureCache::Key::hash() const
+{
+	uint64_t hash = Utility::hashValue(sourceHash, CacheVersion);
+	hash = Utility::hashValue(channels, hash);
+	return Utility::hashValue(colorSpace, hash);
+}
+
+std::string TextureCache::Key::fileName() const
+{
+	char name[32];
+	std::snprintf(name, sizeof(name), "%016" PRIx64, hash());
+	return std::string(Directory) + "/" + name + TextureFile::Extension;
+}
+
+TextureCache::Key TextureCache::makeKey(const void* content, size_t size, int channels, MipGenerator::ColorSpace colorSpace)
+{
+	Key key;
+	key.sourceHash = Utility::hash64(content, size);
+	key.channels = channels;
+	key.colorSpace = int32_t(colorSpace);
+	return key;
+}
+
+TextureCache::Key TextureCache::makeKey(const std::vector<std::shared_ptr<MappedFile>>& contents, int channels, MipGenerator::ColorSpace colorSpace)
+{
+	// ÿԴȻ볤ȣյԴҲıϣ
+	Key key = makeKey(nullptr, 0, channels, colorSpace);
+	for (const std::shared_ptr<MappedFile>& content : contents) {
+		const char* data = content ? content->data() : nullptr;
+		const size_t size = content ? content->size() : 0;
+		key.sourceHash = Utility::hash64(data, size, Utility::hashValue(uint64_t(size), key.sourceHash));
+	}
+	return key;
+}
+
+std::shared_ptr<TextureFile> TextureCache::load(const Key& key)
+{
+	const std::string filename = key.fileName();
+	std::shared_ptr<TextureFile> texture = TextureFile::open(filename);
+	if (!texture || texture->sourceHash() != key.hash()) {
+		return nullptr;
+	}
+	std::cout << "Loaded texture cache: " << filename << std::endl;
+	return texture;
+}
+
+void TextureCache::store(const Key& key, const CompressedTexture& texture)
+{
+	File::createDirectory(Directory);
+	TextureFile::write(key.fileName(), texture, key.hash());
+	std::cout << "Stored texture cache: " << key.fileName() << std::endl;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "block_compressor.hpp"
+#include "texture_file.hpp"
+
+class MappedFile;
+
+// ϵĿѹͼ棬ΪԴͼļݵĹϣϼز
+// һεʱں̨ѹдTextureFile֮ڴӳֱϴѹõmipmap
+class TextureCache
+{
+public:
+	struct Key
+	{
+		uint64_t sourceHash;
+		int32_t channels;
+		int32_t colorSpace;
+
+		// дsourceHashȡʱУ
+		uint64_t hash() const;
+		std::string fileName() const;
+	};
+
+	// contentΪԴͼļݣֱͨӶڴӳϣͬһӳ
+	static Key makeKey(const void* content, size_t size, int channels, MipGenerator::ColorSpace colorSpace);
+	// ɶԴļϳɵͼcontentsͨ˳УȱʧԴΪ
+	static Key makeKey(const std::vector<std::shared_ptr<MappedFile>>& contents, int channels, MipGenerator::ColorSpace colorSpace);
+
+	// ûл򻺴ʱnullptr
+	static std::shared_ptr<TextureFile> load(const Key& key);
+	static void store(const Key& key, const CompressedTexture& texture);
+
+private:
+	static const char* Directory;
+};
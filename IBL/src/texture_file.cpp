@@ -0,0 +1,145 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include "texture_file.hpp"
+#include "image.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	const uint32_t FileVersion = 1;
+	const size_t LevelAlignment = 16;
+
+	struct FileHeader
+	{
+		char magic[4];
+		uint32_t version;
+		uint64_t sourceHash;
+		int32_t format;
+		int32_t srgb;
+		int32_t width;
+		int32_t height;
+		int32_t levels;
+		int32_t reserved;
+	};
+
+	struct LevelIndex
+	{
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	size_t levelBytes(TextureFile::Format format, int width, int height)
+	{
+		switch (format) {
+		case TextureFile::Format::R8:
+			return size_t(width) * height;
+		case TextureFile::Format::RG8:
+			return size_t(width) * height * 2;
+		case TextureFile::Format::RGB8:
+			return size_t(width) * height * 3;
+		case TextureFile::Format::RGBA8:
+			return size_t(width) * height * 4;
+		default:
+			return BlockCompressor::levelBytes(CompressedTexture::Format(format), width, height);
+		}
+	}
+}
+
+const char* TextureFile::Extension = ".tex";
+
+std::shared_ptr<TextureFile> TextureFile::open(const std::string& filename)
+{
+	if (!File::exists(filename)) {
+		return nullptr;
+	}
+
+	std::shared_ptr<TextureFile> texture{ new TextureFile };
+	texture->m_file = MappedFile::open(filename);
+	const char* data = texture->m_file->data();
+	const size_t size = texture->m_file->size();
+	if (size < sizeof(FileHeader)) {
+		return nullptr;
+	}
+
+	FileHeader header;
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, "IBLT", 4) != 0 || header.version != FileVersion ||
+		header.format < 0 || header.format > int32_t(Format::RGBA8) || header.width <= 0 || header.height <= 0 ||
+		header.levels <= 0 || header.levels > Utility::numMipmapLevels(header.width, header.height) ||
+		sizeof(FileHeader) + sizeof(LevelIndex) * header.levels > size) {
+		return nullptr;
+	}
+	texture->m_format = Format(header.format);
+	texture->m_srgb = header.srgb != 0;
+	texture->m_sourceHash = header.sourceHash;
+
+	// ƫƱеĴСʽһ£ԽȡȱȽƫʣСȽϣƫƺܴʱ
+	const LevelIndex* index = reinterpret_cast<const LevelIndex*>(data + sizeof(FileHeader));
+	for (int level = 0; level < header.levels; ++level) {
+		const int width = std::max(header.width >> level, 1);
+		const int height = std::max(header.height >> level, 1);
+		if (index[level].size != levelBytes(texture->m_format, width, height) || index[level].offset > size || size - index[level].offset < index[level].size) {
+			std::cout << "Corrupted texture file: " << filename << std::endl;
+			return nullptr;
+		}
+		texture->m_levels.push_back({ width, height, reinterpret_cast<const uint8_t*>(data + index[level].offset), size_t(index[level].size) });
+	}
+	return texture;
+}
+
+void TextureFile::write(const std::string& filename, const CompressedTexture& texture, uint64_t sourceHash)
+{
+	std::vector<const void*> levels;
+	for (const std::vector<uint8_t>& level : texture.levels) {
+		levels.push_back(level.data());
+	}
+	write(filename, Format(texture.format), texture.srgb, texture.width, texture.height, levels, sourceHash);
+}
+
+void TextureFile::write(const std::string& filename, const std::vector<std::shared_ptr<Image>>& mipChain, bool srgb, uint64_t sourceHash)
+{
+	const Image& base = *mipChain.front();
+	if (base.format() != Image::Format::UNorm8) {
+		throw std::runtime_error("Texture file only supports 8-bit images");
+	}
+	const Format formats[] = { Format::R8, Format::RG8, Format::RGB8, Format::RGBA8 };
+	std::vector<const void*> levels;
+	for (const std::shared_ptr<Image>& image : mipChain) {
+		levels.push_back(image->pixels<unsigned char>());
+	}
+	write(filename, formats[base.channels() - 1], srgb, base.width(), base.height(), levels, sourceHash);
+}
+
+void TextureFile::write(const std::string& filename, Format format, bool srgb, int width, int height,
+	const std::vector<const void*>& levels, uint64_t sourceHash)
+{
+	FileHeader header;
+	std::memset(&header, 0, sizeof(header));
+	std::memcpy(header.magic, "IBLT", 4);
+	header.version = FileVersion;
+	header.sourceHash = sourceHash;
+	header.format = int32_t(format);
+	header.srgb = srgb ? 1 : 0;
+	header.width = width;
+	header.height = height;
+	header.levels = int32_t(levels.size());
+
+	std::vector<LevelIndex> index(levels.size());
+	size_t offset = Utility::roundToPowerOfTwo(sizeof(FileHeader) + sizeof(LevelIndex) * levels.size(), int(LevelAlignment));
+	for (size_t level = 0; level < levels.size(); ++level) {
+		index[level].offset = offset;
+		index[level].size = levelBytes(format, std::max(width >> level, 1), std::max(height >> level, 1));
+		offset = Utility::roundToPowerOfTwo(size_t(offset + index[level].size), int(LevelAlignment));
+	}
+
+	std::vector<char> content(offset, 0);
+	std::memcpy(content.data(), &header, sizeof(header));
+	std::memcpy(content.data() + sizeof(header), index.data(), sizeof(LevelIndex) * index.size());
+	for (size_t level = 0; level < levels.size(); ++level) {
+		std::memcpy(content.data() + index[level].offset, levels[level], size_t(index[level].size));
+	}
+	File::writeBinary(filename, content.data(), content.size());
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "block_compressor.hpp"
+
+class Image;
+class MappedFile;
+
+// ʱͼKTX2ļͷƫƱ֮ǰŵmipmapÿ16ֽڶ
+// ݿǿѹģҲδѹ8λأȡʱֻڴӳ䣬ֱӴӳϴҲ
+class TextureFile
+{
+public:
+	// ѹʽCompressedTexture::Formatȡֵͬ
+	enum class Format : int32_t
+	{
+		BC1,
+		BC4,
+		BC5,
+		BC7,
+		BC6H,
+		R8,
+		RG8,
+		RGB8,
+		RGBA8,
+	};
+
+	struct Level
+	{
+		int width;
+		int height;
+		const uint8_t* data;
+		size_t size;
+	};
+
+	static const char* Extension;
+
+	// ļڻǺϷʱnullptr
+	static std::shared_ptr<TextureFile> open(const std::string& filename);
+
+	// sourceHash¼ԴݣУ飬ԤȴļΪ0
+	static void write(const std::string& filename, const CompressedTexture& texture, uint64_t sourceHash);
+	static void write(const std::string& filename, const std::vector<std::shared_ptr<Image>>& mipChain, bool srgb, uint64_t sourceHash);
+
+	Format format() const { return m_format; }
+	bool isCompressed() const { return m_format < Format::R8; }
+	bool isSRGB() const { return m_srgb; }
+	int width() const { return m_levels.front().width; }
+	int height() const { return m_levels.front().height; }
+	int levels() const { return int(m_levels.size()); }
+	uint64_t sourceHash() const { return m_sourceHash; }
+	const Level& level(int index) const { return m_levels[index]; }
+
+private:
+	TextureFile() = default;
+
+	static void write(const std::string& filename, Format format, bool srgb, int width, int height,
+		const std::vector<const void*>& levels, uint64_t sourceHash);
+
+	std::shared_ptr<MappedFile> m_file;
+	Format m_format;
+	bool m_srgb;
+	uint64_t m_sourceHash;
+	std::vector<Level> m_levels;
+};
@@ -0,0 +1,112 @@
+#include <algorithm>
+#include <exception>
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned int numThreads)
+	: m_stop(false)
+{
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	for (unsigned int i = 0; i < numThreads; ++i) {
+		m_workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_condition.notify_all();
+	for (std::thread& worker : m_workers) {
+		worker.join();
+	}
+}
+
+ThreadPool& ThreadPool::global()
+{
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::workerLoop()
+{
+	for (;;) {
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+			if (m_stop && m_tasks.empty()) {
+				return;
+			}
+			task = std::move(m_tasks.front());
+			m_tasks.pop();
+		}
+		task();
+	}
+}
+
+void ThreadPool::parallelFor(int begin, int end, const std::function<void(int)>& body)
+{
+	if (begin >= end) {
+		return;
+	}
+
+	// ״̬shared_ptr棬ĸûʣ๤ֱ˳
+	// body׳쳣ʱµһ쳣ʣµ±겻ִеȻȫڵ߳׳
+	struct State
+	{
+		std::atomic<int> next;
+		std::atomic<int> remaining;
+		std::atomic<bool> failed;
+		std::exception_ptr error;
+		std::function<void(int)> body;
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+	auto state = std::make_shared<State>();
+	state->next = begin;
+	state->remaining = end - begin;
+	state->failed = false;
+	state->body = body;
+
+	auto run = [state, end]() {
+		for (int i = state->next++; i < end; i = state->next++) {
+			if (!state->failed) {
+				try {
+					state->body(i);
+				}
+				catch (...) {
+					std::lock_guard<std::mutex> lock(state->mutex);
+					if (!state->error) {
+						state->error = std::current_exception();
+					}
+					state->failed = true;
+				}
+			}
+			if (--state->remaining == 0) {
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->done.notify_all();
+			}
+		}
+	};
+
+	const int numHelpers = std::min<int>(size(), end - begin - 1);
+	for (int i = 0; i < numHelpers; ++i) {
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_tasks.emplace(run);
+	}
+	m_condition.notify_all();
+
+	// ߳ͬȡڹ߳Ƕ׵Ҳ
+	run();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->done.wait(lock, [&state]() { return state->remaining == 0; });
+	if (state->error) {
+		std::rethrow_exception(state->error);
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+// 򵥵̳߳أCPU˵ĺ決񶼽
+class ThreadPool
+{
+public:
+	explicit ThreadPool(unsigned int numThreads = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	// ȫֹ̳߳أ߳CPU
+	static ThreadPool& global();
+
+	unsigned int size() const { return static_cast<unsigned int>(m_workers.size()); }
+
+	// ύһ첽
+	template<typename F>
+	auto enqueue(F&& func) -> std::future<decltype(func())>
+	{
+		using R = decltype(func());
+		auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(func));
+		std::future<R> result = task->get_future();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_tasks.emplace([task]() { (*task)(); });
+		}
+		m_condition.notify_one();
+		return result;
+	}
+
+	// ִ body(i), i[begin, end)߳Ҳ㣬ʱȫ
+	// body׳쳣ʱִʣµ±꣬Ѿʼִѵһ쳣׸
+	void parallelFor(int begin, int end, const std::function<void(int)>& body);
+
+private:
+	void workerLoop();
+
+	std::vector<std::thread> m_workers;
+	std::queue<std::function<void()>> m_tasks;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_stop;
+};
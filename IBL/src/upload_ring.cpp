@@ -0,0 +1,85 @@
+#include <stdexcept>
+
+#include "upload_ring.hpp"
+#include "utils.hpp"
+
+namespace
+{
+	// ϴƫư16ֽڶ룬ظʽҪ
+	const size_t Alignment = 16;
+}
+
+UploadRing::UploadRing()
+	: m_buffer(0)
+	, m_mapped(nullptr)
+	, m_segmentSize(0)
+	, m_segment(0)
+	, m_offset(0)
+	, m_fences()
+{}
+
+void UploadRing::create(size_t segmentSize)
+{
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const size_t size = segmentSize * NumSegments;
+
+	glCreateBuffers(1, &m_buffer);
+	glNamedBufferStorage(m_buffer, size, nullptr, flags);
+	m_mapped = static_cast<char*>(glMapNamedBufferRange(m_buffer, 0, size, flags));
+	if (!m_mapped) {
+		throw std::runtime_error("Failed to map upload buffer");
+	}
+	m_segmentSize = segmentSize;
+	m_segment = 0;
+	m_offset = 0;
+}
+
+void UploadRing::destroy()
+{
+	for (GLsync& fence : m_fences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	if (m_buffer) {
+		glUnmapNamedBuffer(m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+	}
+	m_buffer = 0;
+	m_mapped = nullptr;
+}
+
+bool UploadRing::allocate(size_t size, Allocation& allocation, bool blocking)
+{
+	if (size > m_segmentSize) {
+		throw std::runtime_error("Upload does not fit into a staging segment");
+	}
+
+	size_t offset = Utility::roundToPowerOfTwo(m_offset, int(Alignment));
+	if (offset + size > m_segmentSize) {
+		// ǰһοкڴǰύĿ֮fenceȻ󻻵һ
+		// һλûʱfence֮СķԿܷŽǰΣfenceҪ֮
+		const int next = (m_segment + 1) % NumSegments;
+		GLsync& pending = m_fences[next];
+		if (pending) {
+			GLenum result;
+			do {
+				result = glClientWaitSync(pending, GL_SYNC_FLUSH_COMMANDS_BIT, blocking ? 1000000000 : 0);
+			} while (blocking && result == GL_TIMEOUT_EXPIRED);
+			if (result == GL_TIMEOUT_EXPIRED) {
+				return false;
+			}
+			glDeleteSync(pending);
+			pending = nullptr;
+		}
+		m_fences[m_segment] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		m_segment = next;
+		offset = 0;
+	}
+
+	m_offset = offset + size;
+	allocation.offset = size_t(m_segment) * m_segmentSize + offset;
+	allocation.pointer = m_mapped + allocation.offset;
+	return true;
+}
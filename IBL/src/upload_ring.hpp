@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <glad/glad.h>
+
+// ־ӳؽ壨PIXEL_UNPACK_BUFFERη
+// memcpyӳڴglTextureSubImage*ӻ첽̲߳õɿ
+// ֳɶΣÿһfenceٴʹһ֮ǰҪfence
+class UploadRing
+{
+public:
+	static const int NumSegments = 4;
+
+	struct Allocation
+	{
+		size_t offset;	// ڻеƫƣΪglTextureSubImage*pixels
+		void* pointer;	// ӳCPUַ
+	};
+
+	UploadRing();
+
+	void create(size_t segmentSize);
+	void destroy();
+
+	// sizeֽڣһλڱGPUʹʱblockingΪfalse򷵻falseһ֡ԣȴ
+	bool allocate(size_t size, Allocation& allocation, bool blocking);
+
+	GLuint buffer() const { return m_buffer; }
+	size_t segmentSize() const { return m_segmentSize; }
+
+private:
+	GLuint m_buffer;
+	char* m_mapped;
+	size_t m_segmentSize;
+	int m_segment;
+	size_t m_offset;
+	GLsync m_fences[NumSegments];
+};
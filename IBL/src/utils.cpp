@@ -1,39 +1,89 @@
 #include <fstream>
-#include <sstream>
 #include <memory>
 #include <io.h>
+#include <direct.h>
+#include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <stdexcept>
+
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
 
 #include "utils.hpp"
 
-std::string File::readText(const std::string& filename)
+namespace
 {
-
-	std::ifstream file{ filename };
-	file.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-
-	if (!file.is_open()) {
-		throw std::runtime_error("Could not open file: " + filename);
+	// ȡļСһζԤȷõĻ鿽
+	template<typename Buffer> Buffer readWhole(const std::string& filename)
+	{
+		std::FILE* file = std::fopen(filename.c_str(), "rb");
+		if (!file) {
+			throw std::runtime_error("Could not open file: " + filename);
+		}
+
+		Buffer buffer;
+		if (_fseeki64(file, 0, SEEK_END) == 0) {
+			const long long size = _ftelli64(file);
+			if (size > 0) {
+				buffer.resize(size_t(size));
+			}
+		}
+		std::rewind(file);
+		const size_t read = buffer.empty() ? 0 : std::fread(&buffer[0], 1, buffer.size(), file);
+		std::fclose(file);
+		if (read != buffer.size()) {
+			throw std::runtime_error("Could not read file: " + filename);
+		}
+		return buffer;
 	}
+}
 
-	std::stringstream buffer;
-	buffer << file.rdbuf();
-	return buffer.str();
+std::string File::readText(const std::string& filename)
+{
+	return readWhole<std::string>(filename);
 }
 
 std::vector<char> File::readBinary(const std::string& filename)
 {
-	std::ifstream file{ filename, std::ios::binary | std::ios::ate };
-	if (!file.is_open()) {
-		throw std::runtime_error("Could not open file: " + filename);
+	return readWhole<std::vector<char>>(filename);
+}
+
+void File::writeBinary(const std::string& filename, const void* data, size_t size)
+{
+	// дʱļٸ;˳²ļ
+	// ʱļϽ̺̺߳ţ̨ͬʱдͬһļʱţʱֱ滻ɵΪ׼
+	const std::string tempFilename = filename + "." + std::to_string(GetCurrentProcessId()) + "." + std::to_string(GetCurrentThreadId()) + ".tmp";
+	{
+		std::ofstream file{ tempFilename, std::ios::binary | std::ios::trunc };
+		if (!file.is_open()) {
+			throw std::runtime_error("Could not open file for writing: " + filename);
+		}
+		file.write(static_cast<const char*>(data), size);
+		if (!file) {
+			file.close();
+			std::remove(tempFilename.c_str());
+			throw std::runtime_error("Could not write file: " + filename);
+		}
+	}
+	if (!MoveFileExA(tempFilename.c_str(), filename.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+		std::remove(tempFilename.c_str());
+		throw std::runtime_error("Could not rename file: " + tempFilename);
 	}
+}
 
-	std::streamsize size = file.tellg();
-	file.seekg(0, std::ios::beg);
+bool File::exists(const std::string& filename)
+{
+	return _access(filename.c_str(), 0) == 0;
+}
 
-	std::vector<char> buffer(size);
-	file.read(buffer.data(), size);
-	return buffer;
+void File::createDirectory(const std::string& path)
+{
+	// ̨ͬʱͬһĿ¼Ѿڲʧ
+	if (_mkdir(path.c_str()) != 0 && errno != EEXIST) {
+		throw std::runtime_error("Could not create directory: " + path);
+	}
 }
 
 std::vector<char*> File::readAllFilesInDir(const std::string& path)
@@ -120,4 +170,52 @@ std::vector<char*> File::readAllFilesInDirWithExt(const std::string& path)
     }
 
     return files;
-}
\ No newline at end of file
+}
+
+MappedFile::MappedFile()
+	: m_file(INVALID_HANDLE_VALUE)
+	, m_mapping(nullptr)
+	, m_data(nullptr)
+	, m_size(0)
+{}
+
+MappedFile::~MappedFile()
+{
+	if (m_data) {
+		UnmapViewOfFile(m_data);
+	}
+	if (m_mapping) {
+		CloseHandle(m_mapping);
+	}
+	if (m_file != INVALID_HANDLE_VALUE) {
+		CloseHandle(m_file);
+	}
+}
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string& filename)
+{
+	std::shared_ptr<MappedFile> file{ new MappedFile };
+	file->m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (file->m_file == INVALID_HANDLE_VALUE) {
+		throw std::runtime_error("Could not open file: " + filename);
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file->m_file, &size)) {
+		throw std::runtime_error("Could not get file size: " + filename);
+	}
+	file->m_size = size_t(size.QuadPart);
+
+	// ļܴӳ䣬data()Ϊ
+	if (file->m_size > 0) {
+		file->m_mapping = CreateFileMappingA(file->m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!file->m_mapping) {
+			throw std::runtime_error("Could not map file: " + filename);
+		}
+		file->m_data = static_cast<const char*>(MapViewOfFile(file->m_mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!file->m_data) {
+			throw std::runtime_error("Could not map file: " + filename);
+		}
+	}
+	return file;
+}
@@ -1,4 +1,7 @@
 #pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -7,11 +10,38 @@ class File
 public:
 	static std::string readText(const std::string& filename);
 	static std::vector<char> readBinary(const std::string& filename);
+	static void writeBinary(const std::string& filename, const void* data, size_t size);
+	static bool exists(const std::string& filename);
+	static void createDirectory(const std::string& path);
 	static std::vector<char*> readAllFilesInDir(const std::string& path);
 	static std::vector<char*> readAllDirsInDir(const std::string& path);
 	static std::vector<char*> readAllFilesInDirWithExt(const std::string& path);
 };
 
+// ֻڴӳļʱӳ
+// ͼHDRģͶֱӴӳ룬ļݲٿм仺
+class MappedFile
+{
+public:
+	// ʧʱ׳쳣
+	static std::shared_ptr<MappedFile> open(const std::string& filename);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	const char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+
+private:
+	MappedFile();
+
+	void* m_file;
+	void* m_mapping;
+	const char* m_data;
+	size_t m_size;
+};
+
 class Utility
 {
 public:
@@ -33,4 +63,20 @@ public:
 		}
 		return levels;
 	}
+
+	// 64λFNV-1aϣڻļļ
+	static uint64_t hash64(const void* data, size_t size, uint64_t seed = 0xCBF29CE484222325ull)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		uint64_t hash = seed;
+		for (size_t i = 0; i < size; ++i) {
+			hash ^= bytes[i];
+			hash *= 0x100000001B3ull;
+		}
+		return hash;
+	}
+	template<typename T> static uint64_t hashValue(const T& value, uint64_t seed)
+	{
+		return hash64(&value, sizeof(T), seed);
+	}
 };
\ No newline at end of file
@@ -0,0 +1,34 @@
+#include <cstdio>
+#include <chrono>
+#include <string>
+#include <vector>
+
+#include "../src/brdf_lut.hpp"
+
+// LUTGen߻split-sum BRDF LUTֱ#includeı
+// ÷LUTGen.exe [ļ]Ĭд ./src/brdf_lut.incIBLĿ¼У
+int main(int argc, char* argv[])
+{
+	const std::string outputPath = argc > 1 ? argv[1] : "./src/brdf_lut.inc";
+
+	const auto start = std::chrono::steady_clock::now();
+	const std::vector<uint16_t> pixels = BRDFLUT::integrate(BRDFLUT::Size, BRDFLUT::NumSamples);
+	const auto end = std::chrono::steady_clock::now();
+
+	FILE* file = std::fopen(outputPath.c_str(), "wb");
+	if (!file) {
+		std::fprintf(stderr, "Could not open file for writing: %s\n", outputPath.c_str());
+		return 1;
+	}
+
+	std::fprintf(file, "// LUTGenɣֶ޸\n");
+	std::fprintf(file, "// %dx%d RG16F, %d samples, (scale, bias) per texel\n", BRDFLUT::Size, BRDFLUT::Size, BRDFLUT::NumSamples);
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		std::fprintf(file, "0x%04X,%s", pixels[i], (i % 16 == 15) ? "\n" : "");
+	}
+	std::fclose(file);
+
+	std::printf("Wrote %s (%dx%d, %d samples) in %.1f ms\n", outputPath.c_str(), BRDFLUT::Size, BRDFLUT::Size, BRDFLUT::NumSamples,
+		std::chrono::duration<double, std::milli>(end - start).count());
+	return 0;
+}
@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/block_compressor.hpp"
+#include "../src/image.hpp"
+#include "../src/mip_generator.hpp"
+#include "../src/texture_file.hpp"
+
+// TexPack߰ͼTextureFilemipmapĬϿѹʱֱڴӳϴ
+// ÷TexPack.exe <ͼ> <.tex> [srgb|linear|normal] [raw]
+// ģĿ¼£Դͼͬ xxx_albedo.texloadModelsʹãrawʾѹ
+int main(int argc, char* argv[])
+{
+	if (argc < 3) {
+		std::fprintf(stderr, "Usage: TexPack.exe <input> <output.tex> [srgb|linear|normal] [raw]\n");
+		return 1;
+	}
+	const std::string inputPath = argv[1];
+	const std::string outputPath = argv[2];
+	const std::string mode = argc > 3 ? argv[3] : "srgb";
+	const bool raw = argc > 4 && std::strcmp(argv[4], "raw") == 0;
+
+	MipGenerator::ColorSpace colorSpace;
+	if (mode == "srgb") {
+		colorSpace = MipGenerator::ColorSpace::SRGB;
+	}
+	else if (mode == "linear") {
+		colorSpace = MipGenerator::ColorSpace::Linear;
+	}
+	else if (mode == "normal") {
+		colorSpace = MipGenerator::ColorSpace::Normal;
+	}
+	else {
+		std::fprintf(stderr, "Unknown color space: %s\n", mode.c_str());
+		return 1;
+	}
+
+	try {
+		const auto start = std::chrono::steady_clock::now();
+		const std::vector<std::shared_ptr<Image>> mipChain = MipGenerator::generate(Image::fromFile(inputPath, 3), colorSpace);
+		if (raw) {
+			TextureFile::write(outputPath, mipChain, colorSpace == MipGenerator::ColorSpace::SRGB, 0);
+		}
+		else {
+			TextureFile::write(outputPath, *BlockCompressor::compress(mipChain, colorSpace), 0);
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		std::printf("Wrote %s (%dx%d, %d levels, %s) in %.1f ms\n", outputPath.c_str(), mipChain.front()->width(), mipChain.front()->height(),
+			int(mipChain.size()), raw ? "raw" : "compressed", std::chrono::duration<double, std::milli>(end - start).count());
+	}
+	catch (const std::exception& e) {
+		std::fprintf(stderr, "Error: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}